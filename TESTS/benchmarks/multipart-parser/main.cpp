@@ -0,0 +1,122 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Measures MultipartReader throughput on a single large part, as when receiving a firmware
+ * or image upload. The payload is random binary data, or base64 text which shares most of
+ * its characters with the boundary.
+ */
+
+#include <string>
+#include "mbed.h"
+#include "multipart_reader.h"
+#include "utest/utest.h"
+#include "unity/unity.h"
+#include "greentea-client/test_env.h"
+
+using namespace utest::v1;
+
+static const size_t PAYLOAD_SIZE = 1024 * 1024;
+static const size_t BLOCK_SIZE = 4096;
+
+static const char* boundary = "----WebKitFormBoundary7MA4YWxkTrZu0gW";
+static const char* base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static char block[BLOCK_SIZE];
+
+static size_t received;
+static size_t data_callbacks;
+
+static void on_part_data(const char* buffer, size_t size, void* user_data) {
+    received += size;
+    data_callbacks++;
+}
+
+static void fill_block(bool base64) {
+    srand(42);
+    for (size_t ix = 0; ix < BLOCK_SIZE; ix++) {
+        block[ix] = base64 ? base64_chars[rand() % 64] : (char)(rand() & 0xff);
+    }
+}
+
+static void run_benchmark(bool base64, size_t chunk_size) {
+    fill_block(base64);
+
+    std::string head = std::string("--") + boundary + "\r\nContent-Type: application/octet-stream\r\n\r\n";
+    std::string tail = std::string("\r\n--") + boundary + "--\r\n";
+
+    MultipartReader reader(boundary);
+    reader.onPartData = on_part_data;
+    received = 0;
+    data_callbacks = 0;
+
+    Timer t;
+    t.start();
+    reader.feed(head.c_str(), head.size());
+    for (size_t sent = 0; sent < PAYLOAD_SIZE; sent += chunk_size) {
+        reader.feed(block + (sent % BLOCK_SIZE), chunk_size);
+    }
+    reader.feed(tail.c_str(), tail.size());
+    t.stop();
+
+    int us = t.read_us();
+    printf("[BENCH] %s, %u byte chunks: %u KB in %d us (%lu KB/s), %u data callbacks\n",
+           base64 ? "base64" : "binary", (unsigned int)chunk_size, (unsigned int)(PAYLOAD_SIZE / 1024), us,
+           us > 0 ? (unsigned long)((uint64_t)PAYLOAD_SIZE * 1000000 / 1024 / us) : 0UL,
+           (unsigned int)data_callbacks);
+
+    TEST_ASSERT_TRUE(reader.succeeded());
+    TEST_ASSERT_EQUAL(PAYLOAD_SIZE, received);
+}
+
+static control_t bench_binary_512(const size_t call_count) {
+    run_benchmark(false, 512);
+    return CaseNext;
+}
+
+static control_t bench_binary_4096(const size_t call_count) {
+    run_benchmark(false, 4096);
+    return CaseNext;
+}
+
+static control_t bench_base64_512(const size_t call_count) {
+    run_benchmark(true, 512);
+    return CaseNext;
+}
+
+static control_t bench_base64_4096(const size_t call_count) {
+    run_benchmark(true, 4096);
+    return CaseNext;
+}
+
+utest::v1::status_t greentea_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(2*60, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("multipart parser, binary, 512 byte chunks", bench_binary_512),
+    Case("multipart parser, binary, 4096 byte chunks", bench_binary_4096),
+    Case("multipart parser, base64, 512 byte chunks", bench_base64_512),
+    Case("multipart parser, base64, 4096 byte chunks", bench_base64_4096)
+};
+
+Specification specification(greentea_setup, cases);
+
+int main() {
+    return !Harness::run(specification);
+}
@@ -0,0 +1,141 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Compares building requests with HttpRequestBuilder (flat header arena) against
+ * the previous approach of keeping headers in a std::map<string, string>.
+ *
+ * Allocation counts need heap statistics, add "MBED_HEAP_STATS_ENABLED=1" to the macros in mbed_app.json.
+ */
+
+#include <map>
+#include <string>
+#include "mbed.h"
+#include "http_request_builder.h"
+#include "utest/utest.h"
+#include "unity/unity.h"
+#include "greentea-client/test_env.h"
+
+using namespace utest::v1;
+
+static const size_t ITERATIONS = 200;
+
+static const char* header_keys[] = {
+    "Accept", "Accept-Encoding", "Accept-Language", "Authorization", "Cache-Control",
+    "Content-Type", "Cookie", "If-None-Match", "Origin", "Referer",
+    "User-Agent", "X-Request-Id", "X-Device-Id", "X-Firmware-Version", "X-Api-Key",
+    "X-Correlation-Id", "X-Forwarded-For", "Pragma", "Connection", "Upgrade-Insecure-Requests"
+};
+
+static const char* header_value = "some-typical-header-value/1.0";
+
+static uint32_t get_alloc_count() {
+    mbed_stats_heap_t stats;
+    mbed_stats_heap_get(&stats);
+    return stats.alloc_cnt;
+}
+
+// the previous implementation: headers in a map, serialized with sprintf
+static char* build_with_map(http_method method, ParsedUrl* url, size_t header_count, uint32_t& size) {
+    map<string, string> headers;
+    headers.insert(pair<string, string>("Host", url->host()));
+    for (size_t ix = 0; ix < header_count; ix++) {
+        headers[header_keys[ix]] = header_value;
+    }
+
+    const char* method_str = http_method_str(method);
+    size = strlen(method_str) + 1 + strlen(url->path()) + 1 + 8 + 2;
+    for (map<string, string>::iterator it = headers.begin(); it != headers.end(); it++) {
+        size += it->first.length() + 2 + it->second.length() + 2;
+    }
+    size += 2;
+
+    char* req = (char*)calloc(size + 1, 1);
+    char* p = req + sprintf(req, "%s %s HTTP/1.1\r\n", method_str, url->path());
+    for (map<string, string>::iterator it = headers.begin(); it != headers.end(); it++) {
+        p += sprintf(p, "%s: %s\r\n", it->first.c_str(), it->second.c_str());
+    }
+    sprintf(p, "\r\n");
+    return req;
+}
+
+static void run_benchmark(size_t header_count) {
+    ParsedUrl url("http://httpbin.org/get");
+    Timer t;
+    uint32_t size;
+
+    uint32_t allocs_before = get_alloc_count();
+    t.start();
+    for (size_t it = 0; it < ITERATIONS; it++) {
+        char* req = build_with_map(HTTP_GET, &url, header_count, size);
+        free(req);
+    }
+    t.stop();
+    uint32_t map_allocs = (get_alloc_count() - allocs_before) / ITERATIONS;
+    int map_us = t.read_us() / ITERATIONS;
+
+    t.reset();
+    allocs_before = get_alloc_count();
+    t.start();
+    for (size_t it = 0; it < ITERATIONS; it++) {
+        HttpRequestBuilder builder(HTTP_GET, &url);
+        for (size_t ix = 0; ix < header_count; ix++) {
+            builder.set_header(header_keys[ix], header_value);
+        }
+        builder.build_headers(0, size);
+    }
+    t.stop();
+    uint32_t arena_allocs = (get_alloc_count() - allocs_before) / ITERATIONS;
+    int arena_us = t.read_us() / ITERATIONS;
+
+    printf("[BENCH] %u headers: map %d us, %lu allocs | arena %d us, %lu allocs\n",
+           (unsigned int)header_count, map_us, (unsigned long)map_allocs, arena_us, (unsigned long)arena_allocs);
+
+    TEST_ASSERT(size > 0);
+}
+
+static control_t bench_5_headers(const size_t call_count) {
+    run_benchmark(5);
+    return CaseNext;
+}
+
+static control_t bench_10_headers(const size_t call_count) {
+    run_benchmark(10);
+    return CaseNext;
+}
+
+static control_t bench_20_headers(const size_t call_count) {
+    run_benchmark(20);
+    return CaseNext;
+}
+
+utest::v1::status_t greentea_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(1*60, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Case cases[] = {
+    Case("request builder, 5 headers", bench_5_headers),
+    Case("request builder, 10 headers", bench_10_headers),
+    Case("request builder, 20 headers", bench_20_headers)
+};
+
+Specification specification(greentea_setup, cases);
+
+int main() {
+    return !Harness::run(specification);
+}
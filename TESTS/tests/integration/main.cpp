@@ -18,7 +18,16 @@
 #include "mbed.h"
 #include "http_request.h"
 #include "https_request.h"
+#include "http_request_multiplexer.h"
+#include "http_pipeline.h"
+#include "http_pull_parser.h"
+#include "http_resumable_download.h"
+#include "http_segmented_download.h"
 #include "test_setup.h"
+#include "mbedtls/certs.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ssl_cache.h"
 #include "utest/utest.h"
 #include "unity/unity.h"
 #include "greentea-client/test_env.h"
@@ -34,15 +43,9 @@ static void setup_verify_network() {
 
 // verifies that the header is present and has a certain value
 static void assert_header(HttpResponse *res, const char *header, const char *value) {
-    bool headerPresent = false;
-    for (size_t ix = 0; ix < res->get_headers_length(); ix++) {
-        if (res->get_headers_fields()[ix]->compare(header)) {
-            headerPresent = true;
-
-            TEST_ASSERT(res->get_headers_values()[ix]->compare(value));
-        }
-    }
-    TEST_ASSERT_EQUAL(true, headerPresent);
+    HttpStringView header_value = res->get_header(header);
+    TEST_ASSERT_NOT_NULL(header_value.data);
+    TEST_ASSERT(header_value.equals(value));
 }
 
 static control_t http_get(const size_t call_count) {
@@ -54,6 +57,413 @@ static control_t http_get(const size_t call_count) {
     TEST_ASSERT(res);
     TEST_ASSERT_EQUAL(418, res->get_status_code());
 
+    // standard headers are tagged while parsing, others keep HTTP_HEADER_UNKNOWN
+    for (uint32_t ix = 0; ix < res->get_headers_length(); ix++) {
+        http_known_header id = res->get_header_id(ix);
+        if (id == HTTP_HEADER_UNKNOWN) {
+            TEST_ASSERT_FALSE(res->get_header_field(ix).iequals("content-length"));
+        }
+        else {
+            TEST_ASSERT(res->get_header_field(ix).iequals(http_known_header_names[id]));
+        }
+    }
+    TEST_ASSERT_NOT_NULL(res->get_header(HTTP_HEADER_CONTENT_LENGTH).data);
+
+    delete req;
+
+    return CaseNext;
+}
+
+static control_t http_body_sink(const size_t call_count) {
+    setup_verify_network();
+
+    MemoryBodySink sink;
+    HttpRequest *req = new HttpRequest(network, HTTP_GET, "http://httpbin.org/bytes/4096");
+    req->set_body_sink(&sink);
+
+    HttpResponse* res = req->send();
+    TEST_ASSERT(res);
+    TEST_ASSERT_EQUAL(200, res->get_status_code());
+    TEST_ASSERT_EQUAL(4096, sink.get_size());
+
+    delete req;
+
+    // a full sink fails the request
+    MemoryBodySink small_sink(1024);
+    req = new HttpRequest(network, HTTP_GET, "http://httpbin.org/bytes/4096");
+    req->set_body_sink(&small_sink);
+
+    TEST_ASSERT_NULL(req->send());
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_NO_MEMORY, req->get_error());
+
+    delete req;
+
+    return CaseNext;
+}
+
+static control_t http_resumable_download(const size_t call_count) {
+    setup_verify_network();
+
+    // httpbin serves 'abcd...xyzabcd...', pretend the first 1000 bytes were stored earlier
+    MemoryBodySink sink;
+    ResumableDownload download(network, "http://httpbin.org/range/1024", &sink);
+
+    DownloadState state;
+    memset(&state, 0, sizeof(state));
+    state.offset = 1000;
+    download.set_state(state);
+
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, download.run());
+    TEST_ASSERT_EQUAL(206, download.get_status_code());
+    TEST_ASSERT_EQUAL(24, sink.get_size());
+    TEST_ASSERT_EQUAL('a' + (1000 % 26), sink.get_data()[0]);
+    TEST_ASSERT_EQUAL(1024, download.get_state().offset);
+    TEST_ASSERT_EQUAL(1024, download.get_state().total);
+
+    return CaseNext;
+}
+
+// TCPSocket that answers every request with a canned response, and closes the connection after drop_after bytes
+class ScriptedSocket : public TCPSocket {
+public:
+    ScriptedSocket() : _drop_after(0), _sent(0), _sends(0) {}
+
+    void set_response(const string& response, size_t drop_after = 0) {
+        _response = response;
+        _drop_after = drop_after > 0 ? drop_after : response.size();
+        _sent = 0;
+        _sends = 0;
+        _request.clear();
+    }
+
+    const string& get_request() {
+        return _request;
+    }
+
+    size_t get_sends() {
+        return _sends;
+    }
+
+    virtual nsapi_size_or_error_t send(const void* data, nsapi_size_t size) {
+        _request.append((const char*)data, size);
+        _sends++;
+        return size;
+    }
+
+    virtual nsapi_size_or_error_t recv(void* data, nsapi_size_t size) {
+        // small reads, so the body arrives in several callbacks
+        size_t length = _drop_after - _sent;
+        if (length > size) length = size;
+        if (length > 100) length = 100;
+
+        memcpy(data, _response.data() + _sent, length);
+        _sent += length;
+        return length;
+    }
+
+private:
+    string _response;
+    string _request;
+    size_t _drop_after;
+    size_t _sent;
+    size_t _sends;
+};
+
+// ResumableDownload that sends every attempt over the next scripted socket
+class ScriptedDownload : public ResumableDownload {
+public:
+    ScriptedDownload(BodySink* sink, ScriptedSocket* sockets)
+        : ResumableDownload(NULL, "http://example.com/firmware.bin", sink), _sockets(sockets), _next(0)
+    {
+        set_retry(3, 0);
+    }
+
+private:
+    virtual HttpRequestBase* create_request(Callback<void(const char*, uint32_t)> body_cb) {
+        return new HttpRequest(&_sockets[_next++], HTTP_GET, "http://example.com/firmware.bin", body_cb);
+    }
+
+    ScriptedSocket* _sockets;
+    size_t _next;
+};
+
+static string scripted_response(const char* status, const char* headers, const string& body) {
+    char length[48];
+    snprintf(length, sizeof(length), "Content-Length: %u\r\n\r\n", (unsigned)body.size());
+    return string("HTTP/1.1 ") + status + "\r\n" + headers + length + body;
+}
+
+static control_t http_resumable_download_retry(const size_t call_count) {
+    string body;
+    for (size_t ix = 0; ix < 1000; ix++) {
+        body += (char)('a' + ix % 26);
+    }
+
+    // the connection drops after 400 bytes of the body, the retry asks for the rest of the same version
+    {
+        MemoryBodySink sink;
+        ScriptedSocket sockets[2];
+        string first = scripted_response("200 OK", "ETag: \"v1\"\r\n", body);
+        sockets[0].set_response(first, first.size() - 600);
+        sockets[1].set_response(scripted_response("206 Partial Content",
+            "ETag: \"v1\"\r\nContent-Range: bytes 400-999/1000\r\n", body.substr(400)));
+
+        ScriptedDownload download(&sink, sockets);
+        TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, download.run());
+        TEST_ASSERT_EQUAL(2, download.get_attempts());
+        TEST_ASSERT_EQUAL(0, download.get_restarts());
+        TEST_ASSERT_EQUAL(206, download.get_status_code());
+        TEST_ASSERT(sockets[1].get_request().find("Range: bytes=400-\r\n") != string::npos);
+        TEST_ASSERT(sockets[1].get_request().find("If-Range: \"v1\"\r\n") != string::npos);
+        TEST_ASSERT_EQUAL(1000, sink.get_size());
+        TEST_ASSERT_EQUAL(0, memcmp(body.data(), sink.get_data(), 1000));
+        TEST_ASSERT_EQUAL(1000, download.get_state().offset);
+        TEST_ASSERT_EQUAL(1000, download.get_state().total);
+    }
+
+    // the resource changed since the stored state, the server sends all of it and the sink starts over
+    {
+        MemoryBodySink sink;
+        sink.write("stale", 5);
+        ScriptedSocket sockets[1];
+        sockets[0].set_response(scripted_response("200 OK", "ETag: \"v2\"\r\n", body));
+
+        DownloadState state;
+        memset(&state, 0, sizeof(state));
+        state.offset = 5;
+        state.total = 1000;
+        strcpy(state.validator, "\"v1\"");
+
+        ScriptedDownload download(&sink, sockets);
+        download.set_state(state);
+        TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, download.run());
+        TEST_ASSERT_EQUAL(1, download.get_restarts());
+        TEST_ASSERT(sockets[0].get_request().find("Range: bytes=5-\r\n") != string::npos);
+        TEST_ASSERT(sockets[0].get_request().find("If-Range: \"v1\"\r\n") != string::npos);
+        TEST_ASSERT_EQUAL(1000, sink.get_size());
+        TEST_ASSERT_EQUAL(0, memcmp(body.data(), sink.get_data(), 1000));
+        TEST_ASSERT_EQUAL_STRING("\"v2\"", download.get_state().validator);
+    }
+
+    // everything was stored before the reset, the server has nothing left to send
+    {
+        MemoryBodySink sink;
+        ScriptedSocket sockets[1];
+        sockets[0].set_response(scripted_response("416 Range Not Satisfiable", "Content-Range: bytes */1000\r\n", ""));
+
+        DownloadState state;
+        memset(&state, 0, sizeof(state));
+        state.offset = 1000;
+        state.total = 1000;
+        strcpy(state.validator, "\"v1\"");
+
+        ScriptedDownload download(&sink, sockets);
+        download.set_state(state);
+        TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, download.run());
+        TEST_ASSERT_EQUAL(1, download.get_attempts());
+        TEST_ASSERT_EQUAL(416, download.get_status_code());
+        TEST_ASSERT_EQUAL(0, sink.get_size());
+        TEST_ASSERT_EQUAL(1000, download.get_state().offset);
+    }
+
+    return CaseNext;
+}
+
+static control_t http_response_body_growth(const size_t call_count) {
+    string body;
+    for (size_t ix = 0; ix < 5000; ix++) {
+        body += (char)('a' + ix % 26);
+    }
+
+    // the length is known up front, the body is allocated once and every byte is copied once
+    {
+        ScriptedSocket socket;
+        socket.set_response(scripted_response("200 OK", "", body));
+
+        HttpRequest* req = new HttpRequest(&socket, HTTP_GET, "http://example.com/data");
+        HttpResponse* res = req->send();
+        TEST_ASSERT(res);
+        TEST_ASSERT_EQUAL(5000, res->get_body_length());
+        TEST_ASSERT_EQUAL(0, memcmp(body.data(), res->get_body(), 5000));
+        TEST_ASSERT_EQUAL(1, res->get_body_allocations());
+        TEST_ASSERT_EQUAL(5000, res->get_body_bytes_copied());
+        TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, res->get_body_error());
+        delete req;
+    }
+
+    // chunked, the buffer doubles from HTTP_RESPONSE_BODY_INITIAL_SIZE and is shrunk to fit at the end
+    {
+        string response("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n");
+        for (size_t offset = 0; offset < body.size(); offset += 500) {
+            response += "1f4\r\n" + body.substr(offset, 500) + "\r\n";
+        }
+        response += "0\r\n\r\n";
+
+        ScriptedSocket socket;
+        socket.set_response(response);
+
+        HttpRequest* req = new HttpRequest(&socket, HTTP_GET, "http://example.com/data");
+        HttpResponse* res = req->send();
+        TEST_ASSERT(res);
+        TEST_ASSERT_EQUAL(5000, res->get_body_length());
+        TEST_ASSERT_EQUAL(0, memcmp(body.data(), res->get_body(), 5000));
+
+        uint32_t grows = 1;
+        for (uint32_t capacity = HTTP_RESPONSE_BODY_INITIAL_SIZE; capacity < 5000; capacity *= 2) {
+            grows++;
+        }
+        TEST_ASSERT_EQUAL(grows + 1, res->get_body_allocations());
+
+        // every received byte once, plus at most the body for each time realloc moved it
+        TEST_ASSERT(res->get_body_bytes_copied() >= 5000);
+        TEST_ASSERT(res->get_body_bytes_copied() <= 5000 * (grows + 1));
+        TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, res->get_body_error());
+        delete req;
+    }
+
+    return CaseNext;
+}
+
+static vector<string> upload_chunks;
+static size_t upload_chunk_ix;
+
+static const void* get_upload_chunk(uint32_t* out_size) {
+    if (upload_chunk_ix == upload_chunks.size()) {
+        *out_size = 0;
+        return NULL;
+    }
+    *out_size = upload_chunks[upload_chunk_ix].size();
+    return upload_chunks[upload_chunk_ix++].data();
+}
+
+static control_t http_chunked_writer(const size_t call_count) {
+    // small chunks that are coalesced, and one that is larger than the staging buffer
+    string large(2 * HTTP_CHUNKED_BUFFER_SIZE, 'x');
+    upload_chunks.clear();
+    upload_chunks.push_back("hello");
+    upload_chunks.push_back(" ");
+    upload_chunks.push_back("world");
+    upload_chunks.push_back(large);
+    upload_chunks.push_back("done");
+    upload_chunk_ix = 0;
+
+    ScriptedSocket socket;
+    socket.set_response(scripted_response("200 OK", "", "ok"));
+
+    HttpRequest* req = new HttpRequest(&socket, HTTP_POST, "http://example.com/upload");
+    HttpResponse* res = req->send(&get_upload_chunk);
+    TEST_ASSERT(res);
+    TEST_ASSERT_EQUAL(200, res->get_status_code());
+
+    char large_size[16];
+    snprintf(large_size, sizeof(large_size), "%X\r\n", (unsigned)large.size());
+    string expected = string("5\r\nhello\r\n") + "1\r\n \r\n" + "5\r\nworld\r\n" +
+        large_size + large + "\r\n" + "4\r\ndone\r\n" + "0\r\n\r\n";
+
+    const string& request = socket.get_request();
+    size_t body_ix = request.find("\r\n\r\n");
+    TEST_ASSERT(body_ix != string::npos);
+    TEST_ASSERT(request.find("Transfer-Encoding: chunked\r\n") < body_ix);
+    TEST_ASSERT(request.substr(body_ix + 4) == expected);
+
+    // the headers and small chunks fill up the buffer in front of the large chunk, the rest of it is written
+    // directly, and the last chunks and terminator go out together
+    ChunkedWriterStats stats = req->get_chunked_stats();
+    TEST_ASSERT_EQUAL(5, stats.chunks);
+    TEST_ASSERT_EQUAL(5 + 1 + 5 + large.size() + 4, stats.payload_bytes);
+    TEST_ASSERT_EQUAL(request.size(), stats.wire_bytes);
+    TEST_ASSERT_EQUAL(3, stats.writes);
+    TEST_ASSERT_EQUAL(3, socket.get_sends());
+
+    delete req;
+
+    return CaseNext;
+}
+
+static control_t http_response_cache(const size_t call_count) {
+    setup_verify_network();
+
+    MemoryCacheStorage storage;
+    ResponseCache cache(&storage);
+
+    // max-age=60, so the second request is answered from the cache
+    for (size_t ix = 0; ix < 2; ix++) {
+        HttpRequest *req = new HttpRequest(network, HTTP_GET, "http://httpbin.org/cache/60");
+        req->set_response_cache(&cache);
+
+        HttpResponse* res = req->send();
+        TEST_ASSERT(res);
+        TEST_ASSERT_EQUAL(200, res->get_status_code());
+        TEST_ASSERT(res->get_body_length() > 0);
+
+        delete req;
+    }
+    TEST_ASSERT_EQUAL(1, cache.get_misses());
+    TEST_ASSERT_EQUAL(1, cache.get_hits());
+
+    // only an ETag, so the second request is revalidated, and the 304 becomes the cached 200
+    for (size_t ix = 0; ix < 2; ix++) {
+        HttpRequest *req = new HttpRequest(network, HTTP_GET, "http://httpbin.org/etag/mbed");
+        req->set_response_cache(&cache);
+
+        HttpResponse* res = req->send();
+        TEST_ASSERT(res);
+        TEST_ASSERT_EQUAL(200, res->get_status_code());
+        assert_header(res, "ETag", "\"mbed\"");
+
+        delete req;
+    }
+    TEST_ASSERT_EQUAL(1, cache.get_revalidations());
+    TEST_ASSERT_EQUAL(2, storage.get_entries());
+
+    // not stored: private, varies on another header than Accept-Encoding, or already older than its max-age
+    const char* uncacheable[] = {
+        "http://httpbin.org/response-headers?Cache-Control=private%2C%20max-age%3D60",
+        "http://httpbin.org/response-headers?Cache-Control=max-age%3D60&Vary=Cookie",
+        "http://httpbin.org/response-headers?Cache-Control=max-age%3D60&Age=120"
+    };
+    for (size_t ix = 0; ix < sizeof(uncacheable) / sizeof(uncacheable[0]); ix++) {
+        HttpRequest *req = new HttpRequest(network, HTTP_GET, uncacheable[ix]);
+        req->set_response_cache(&cache);
+
+        HttpResponse* res = req->send();
+        TEST_ASSERT(res);
+        TEST_ASSERT_EQUAL(200, res->get_status_code());
+
+        delete req;
+    }
+    TEST_ASSERT_EQUAL(2, cache.get_stores());
+
+    // the response to a request with credentials is never taken from the cache
+    uint32_t lookups = cache.get_lookups();
+    HttpRequest *req = new HttpRequest(network, HTTP_GET, "http://httpbin.org/cache/60");
+    req->set_response_cache(&cache);
+    req->set_header("Authorization", "Basic dXNlcjpwYXNzd2Q=");
+
+    HttpResponse* res = req->send();
+    TEST_ASSERT(res);
+    TEST_ASSERT_EQUAL(200, res->get_status_code());
+    TEST_ASSERT_EQUAL(lookups, cache.get_lookups());
+    TEST_ASSERT_EQUAL(2, cache.get_stores());
+
+    delete req;
+
+    return CaseNext;
+}
+
+static control_t http_content_decoding(const size_t call_count) {
+    setup_verify_network();
+
+    HttpRequest *req = new HttpRequest(network, HTTP_GET, "http://httpbin.org/gzip");
+    req->set_content_decoding();
+
+    HttpResponse* res = req->send();
+    TEST_ASSERT(res);
+    TEST_ASSERT_EQUAL(200, res->get_status_code());
+    TEST_ASSERT(res->get_content_decoded());
+    TEST_ASSERT(res->get_body_decoded_length() > res->get_body_encoded_length());
+    TEST_ASSERT(res->get_body_as_string().find("\"gzipped\": true") != string::npos);
+
     delete req;
 
     return CaseNext;
@@ -84,6 +494,269 @@ static control_t http_post(const size_t call_count) {
     return CaseNext;
 }
 
+static control_t http_post_compressed(const size_t call_count) {
+    setup_verify_network();
+
+    HttpRequest* req = new HttpRequest(network, HTTP_POST, "http://httpbin.org/post");
+    req->set_header("Content-Type", "application/json");
+    req->set_body_compression();
+
+    string body = "[";
+    for (int ix = 0; ix < 100; ix++) {
+        body += "{\"mykey\":\"mbedvalue\"},";
+    }
+    body += "{}]";
+
+    HttpResponse* res = req->send(body.c_str(), body.length());
+    TEST_ASSERT(res);
+    TEST_ASSERT_EQUAL(200, res->get_status_code());
+
+    // httpbin echoes the request headers
+    TEST_ASSERT_NOT_EQUAL(res->get_body_as_string().find("\"Content-Encoding\": \"gzip\""), string::npos);
+
+    TEST_ASSERT_EQUAL(body.length(), req->get_body_uncompressed_size());
+    TEST_ASSERT(req->get_chunked_stats().payload_bytes < body.length() / 4);
+
+    delete req;
+
+    return CaseNext;
+}
+
+static Semaphore async_done_sem(0);
+static HttpResponse* async_response;
+
+static void async_done(HttpResponse* res) {
+    async_response = res;
+    async_done_sem.release();
+}
+
+static control_t http_get_async(const size_t call_count) {
+    setup_verify_network();
+
+    EventQueue queue;
+    Thread queue_thread;
+    queue_thread.start(callback(&queue, &EventQueue::dispatch_forever));
+
+    HttpRequest *req = new HttpRequest(network, HTTP_GET, "http://httpbin.org/status/418");
+
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, req->send_async(&queue, callback(&async_done)));
+    TEST_ASSERT(async_done_sem.wait(30000) > 0);
+
+    TEST_ASSERT(async_response);
+    TEST_ASSERT_EQUAL(418, async_response->get_status_code());
+
+    delete req;
+
+    queue.break_dispatch();
+    queue_thread.join();
+
+    return CaseNext;
+}
+
+static void async_noop() {
+}
+
+static control_t http_get_async_queue_full(const size_t call_count) {
+    setup_verify_network();
+
+    // room for a few events only, all taken by timers that never fire during the test
+    EventQueue queue(4 * EVENTS_EVENT_SIZE);
+    while (queue.call_in(60000, &async_noop) != 0) {
+    }
+
+    HttpRequest *req = new HttpRequest(network, HTTP_GET, "http://httpbin.org/status/418");
+
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_NO_MEMORY, req->send_async(&queue, callback(&async_done)));
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_NO_MEMORY, req->get_error());
+
+    delete req;
+
+    return CaseNext;
+}
+
+static HttpRequest* async_cancel_request;
+
+static void async_cancel_headers(HttpResponse* res) {
+    async_cancel_request->cancel_async();
+}
+
+static void async_cancel_done(HttpResponse* res) {
+    // the step queued by cancel_async() must not run on the deleted request
+    delete async_cancel_request;
+    async_cancel_request = NULL;
+    async_done_sem.release();
+}
+
+static control_t http_get_async_cancel(const size_t call_count) {
+    setup_verify_network();
+
+    EventQueue queue;
+
+    async_cancel_request = new HttpRequest(network, HTTP_GET, "http://httpbin.org/bytes/100");
+    async_cancel_request->set_headers_callback(callback(&async_cancel_headers));
+
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, async_cancel_request->send_async(&queue, callback(&async_cancel_done)));
+
+    // keep dispatching for a while after the request is gone
+    while (async_done_sem.wait(0) <= 0) {
+        queue.dispatch(100);
+    }
+    queue.dispatch(500);
+
+    TEST_ASSERT_NULL(async_cancel_request);
+
+    return CaseNext;
+}
+
+static uint32_t multiplexer_ok_count;
+
+static void multiplexer_done(HttpRequestBase* req, HttpResponse* res) {
+    if (res && res->get_status_code() == 418) {
+        multiplexer_ok_count++;
+    }
+}
+
+static control_t http_multiplexer(const size_t call_count) {
+    setup_verify_network();
+
+    const size_t request_count = 4;
+    HttpRequest* reqs[request_count];
+
+    EventQueue queue;
+    RequestMultiplexer multi(&queue, 2);
+    multiplexer_ok_count = 0;
+
+    for (size_t ix = 0; ix < request_count; ix++) {
+        reqs[ix] = new HttpRequest(network, HTTP_GET, "http://httpbin.org/status/418");
+        multi.add(reqs[ix], callback(&multiplexer_done));
+    }
+
+    multi.run();
+
+    TEST_ASSERT_EQUAL(request_count, multi.get_completed());
+    TEST_ASSERT_EQUAL(request_count, multiplexer_ok_count);
+
+    for (size_t ix = 0; ix < request_count; ix++) {
+        delete reqs[ix];
+    }
+
+    return CaseNext;
+}
+
+// keeps a copy of the last entry it stored, so the test can write it back damaged
+class RecordingCacheStorage : public MemoryCacheStorage {
+public:
+    virtual nsapi_error_t store(const char* key, const char* data, uint32_t size) {
+        last_key = key;
+        last_data.assign(data, size);
+        return MemoryCacheStorage::store(key, data, size);
+    }
+
+    string last_key;
+    string last_data;
+};
+
+static control_t http_response_cache_damaged(const size_t call_count) {
+    setup_verify_network();
+
+    RecordingCacheStorage storage;
+    ResponseCache cache(&storage);
+
+    HttpRequest *req = new HttpRequest(network, HTTP_GET, "http://httpbin.org/cache/60");
+    req->set_response_cache(&cache);
+    TEST_ASSERT(req->send());
+    delete req;
+
+    string key = storage.last_key;
+    string entry = storage.last_data;
+    TEST_ASSERT(entry.size() > 0);
+
+    bool fresh = false;
+    ResponseCacheEntry* loaded = cache.lookup(key.c_str(), &fresh);
+    TEST_ASSERT_NOT_NULL(loaded);
+    delete loaded;
+
+    // e.g. a file that was only partly written before a reset
+    for (uint32_t size = 0; size < entry.size(); size++) {
+        storage.store(key.c_str(), entry.data(), size);
+        TEST_ASSERT_NULL(cache.lookup(key.c_str(), &fresh));
+    }
+
+    // a length of the status message that runs past the end of the entry
+    string status("\x02\x00\x00\x00OK", 6);
+    size_t status_ix = entry.find(status);
+    TEST_ASSERT(status_ix != string::npos);
+    entry[status_ix + 2] = '\x01';
+    storage.store(key.c_str(), entry.data(), entry.size());
+    TEST_ASSERT_NULL(cache.lookup(key.c_str(), &fresh));
+
+    return CaseNext;
+}
+
+static control_t http_segmented_download(const size_t call_count) {
+    setup_verify_network();
+
+    EventQueue queue;
+    MemoryRandomAccessSink sink;
+    SegmentedDownload download(&queue, network, "http://httpbin.org/range/32768", &sink, 4);
+    download.set_min_segment_size(4096);
+
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, download.run());
+    TEST_ASSERT_EQUAL(32768, download.get_total_size());
+    TEST_ASSERT_EQUAL(32768, sink.get_size());
+    TEST_ASSERT(download.get_segment_count() >= 4);
+
+    for (size_t ix = 0; ix < sink.get_size(); ix++) {
+        TEST_ASSERT_EQUAL('a' + (ix % 26), sink.get_data()[ix]);
+    }
+
+    uint32_t received = 0;
+    for (uint32_t ix = 0; ix < download.get_segment_count(); ix++) {
+        DownloadSegment segment = download.get_segment(ix);
+        TEST_ASSERT_EQUAL(segment.end - segment.start, segment.received);
+        received += segment.received;
+    }
+    TEST_ASSERT_EQUAL(32768, received);
+
+    return CaseNext;
+}
+
+static control_t http_segmented_download_unresolvable(const size_t call_count) {
+    setup_verify_network();
+
+    // every request fails before it is sent, the retries still need to run before run() gives up
+    EventQueue queue;
+    MemoryRandomAccessSink sink;
+    SegmentedDownload download(&queue, network, "http://does-not-exist.invalid/range/1024", &sink, 4);
+    download.set_retry(3, 10);
+
+    nsapi_error_t ret = download.run();
+    TEST_ASSERT_NOT_EQUAL(NSAPI_ERROR_OK, ret);
+    TEST_ASSERT_EQUAL(ret, download.get_error());
+    TEST_ASSERT_EQUAL(1, download.get_segment_count());
+    TEST_ASSERT_EQUAL(3, download.get_segment(0).requests);
+    TEST_ASSERT_EQUAL(0, sink.get_size());
+
+    return CaseNext;
+}
+
+static control_t http_segmented_download_queue_full(const size_t call_count) {
+    setup_verify_network();
+
+    // nothing can be queued, run() returns instead of dispatching a queue that has no work for it
+    EventQueue queue(4 * EVENTS_EVENT_SIZE);
+    while (queue.call_in(60000, &async_noop) != 0) {
+    }
+
+    MemoryRandomAccessSink sink;
+    SegmentedDownload download(&queue, network, "http://httpbin.org/range/1024", &sink, 4);
+
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_NO_MEMORY, download.run());
+    TEST_ASSERT_EQUAL(0, sink.get_size());
+
+    return CaseNext;
+}
+
 static control_t http_socket_reuse(const size_t call_count) {
     setup_verify_network();
 
@@ -117,6 +790,237 @@ static control_t http_socket_reuse(const size_t call_count) {
     return CaseNext;
 }
 
+static control_t http_connection_pool(const size_t call_count) {
+    setup_verify_network();
+
+    ConnectionPool pool;
+
+    for (size_t ix = 0; ix < 2; ix++) {
+        HttpRequest *req = new HttpRequest(network, HTTP_GET, "http://httpbin.org/status/418");
+        req->set_connection_pool(&pool);
+
+        HttpResponse* res = req->send();
+        TEST_ASSERT(res);
+        TEST_ASSERT_EQUAL(418, res->get_status_code());
+
+        delete req;
+
+        // the keep-alive socket was handed back to the pool
+        TEST_ASSERT_EQUAL(1, pool.get_idle_count());
+    }
+
+    return CaseNext;
+}
+
+static control_t http_dns_cache(const size_t call_count) {
+    setup_verify_network();
+
+    DnsCache dns_cache;
+
+    // only the first request goes to the resolver
+    for (size_t ix = 0; ix < 2; ix++) {
+        HttpRequest *req = new HttpRequest(network, HTTP_GET, "http://httpbin.org/status/418");
+        req->set_dns_cache(&dns_cache);
+
+        HttpResponse* res = req->send();
+        TEST_ASSERT(res);
+        TEST_ASSERT_EQUAL(418, res->get_status_code());
+
+        delete req;
+    }
+    TEST_ASSERT_EQUAL(1, dns_cache.get_misses());
+    TEST_ASSERT_EQUAL(1, dns_cache.get_hits());
+
+    // failed lookups are cached as well
+    SocketAddress address;
+    for (size_t ix = 0; ix < 2; ix++) {
+        TEST_ASSERT_NOT_EQUAL(NSAPI_ERROR_OK, dns_cache.resolve(network, "does-not-exist.invalid", &address));
+    }
+    TEST_ASSERT_EQUAL(2, dns_cache.get_misses());
+    TEST_ASSERT_EQUAL(2, dns_cache.get_hits());
+
+    // nothing listens on port 1, after the failed connect the host is looked up again
+    HttpRequest *req = new HttpRequest(network, HTTP_GET, "http://127.0.0.1:1/");
+    req->set_dns_cache(&dns_cache);
+    TEST_ASSERT_NULL(req->send());
+    delete req;
+    TEST_ASSERT_EQUAL(3, dns_cache.get_misses());
+
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, dns_cache.resolve(network, "127.0.0.1", &address));
+    TEST_ASSERT_EQUAL(4, dns_cache.get_misses());
+    TEST_ASSERT_EQUAL(2, dns_cache.get_hits());
+
+    return CaseNext;
+}
+
+static control_t http_buffer_pool(const size_t call_count) {
+    setup_verify_network();
+
+    BufferPool pool;
+
+    for (size_t ix = 0; ix < 2; ix++) {
+        HttpRequest *req = new HttpRequest(network, HTTP_GET, "http://httpbin.org/status/418");
+        req->set_buffer_pool(&pool);
+
+        HttpResponse* res = req->send();
+        TEST_ASSERT(res);
+        TEST_ASSERT_EQUAL(418, res->get_status_code());
+
+        delete req;
+
+        // the buffer was handed back to the pool
+        TEST_ASSERT_EQUAL(0, pool.get_in_use());
+    }
+
+    TEST_ASSERT_EQUAL(HTTP_RECEIVE_BUFFER_SIZE, pool.get_high_water());
+    TEST_ASSERT_EQUAL(0, pool.get_misses());
+
+    return CaseNext;
+}
+
+static vector<int> pipelined_headers;
+
+static void pipelined_headers_cb(HttpResponse* res) {
+    pipelined_headers.push_back(res->get_status_code());
+}
+
+static control_t http_pipelining(const size_t call_count) {
+    setup_verify_network();
+
+    TCPSocket socket;
+    nsapi_error_t open_result = socket.open(network);
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, open_result);
+
+    nsapi_error_t connect_result = socket.connect("httpbin.org", 80);
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, connect_result);
+
+    HttpPipeline pipeline(&socket);
+
+    HttpRequest *req1 = new HttpRequest(&socket, HTTP_GET, "http://httpbin.org/status/404");
+    HttpRequest *req2 = new HttpRequest(&socket, HTTP_GET, "http://httpbin.org/status/403");
+    req1->set_headers_callback(&pipelined_headers_cb);
+    req2->set_headers_callback(&pipelined_headers_cb);
+    pipeline.add(req1);
+    pipeline.add(req2);
+
+    pipelined_headers.clear();
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, pipeline.send());
+
+    TEST_ASSERT(pipeline.get_response(0));
+    TEST_ASSERT_EQUAL(404, pipeline.get_response(0)->get_status_code());
+    TEST_ASSERT(pipeline.get_response(1));
+    TEST_ASSERT_EQUAL(403, pipeline.get_response(1)->get_status_code());
+
+    // every request gets its own headers callback
+    TEST_ASSERT_EQUAL(2, pipelined_headers.size());
+    TEST_ASSERT_EQUAL(404, pipelined_headers[0]);
+    TEST_ASSERT_EQUAL(403, pipelined_headers[1]);
+
+    delete req1;
+    delete req2;
+
+    return CaseNext;
+}
+
+static control_t http_pipelining_head(const size_t call_count) {
+    setup_verify_network();
+
+    TCPSocket socket;
+    nsapi_error_t open_result = socket.open(network);
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, open_result);
+
+    nsapi_error_t connect_result = socket.connect("httpbin.org", 80);
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, connect_result);
+
+    HttpPipeline pipeline(&socket);
+
+    // the HEAD response has a Content-Length but no body, the GET response follows right after its headers
+    HttpRequest *req1 = new HttpRequest(&socket, HTTP_HEAD, "http://httpbin.org/bytes/100");
+    HttpRequest *req2 = new HttpRequest(&socket, HTTP_GET, "http://httpbin.org/bytes/50");
+    pipeline.add(req1);
+    pipeline.add(req2);
+
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, pipeline.send());
+
+    TEST_ASSERT(pipeline.get_response(0));
+    TEST_ASSERT_EQUAL(200, pipeline.get_response(0)->get_status_code());
+    TEST_ASSERT_EQUAL(0, pipeline.get_response(0)->get_body_length());
+    TEST_ASSERT(pipeline.get_response(1));
+    TEST_ASSERT_EQUAL(200, pipeline.get_response(1)->get_status_code());
+    TEST_ASSERT_EQUAL(50, pipeline.get_response(1)->get_body_length());
+
+    delete req1;
+    delete req2;
+
+    return CaseNext;
+}
+
+static control_t http_pull_parser(const size_t call_count) {
+    setup_verify_network();
+
+    TCPSocket socket;
+    nsapi_error_t open_result = socket.open(network);
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, open_result);
+
+    nsapi_error_t connect_result = socket.connect("httpbin.org", 80);
+    TEST_ASSERT_EQUAL(NSAPI_ERROR_OK, connect_result);
+
+    const char* request = "GET /stream-bytes/2048?chunk_size=100 HTTP/1.1\r\nHost: httpbin.org\r\nConnection: close\r\n\r\n";
+    TEST_ASSERT_EQUAL(strlen(request), socket.send(request, strlen(request)));
+
+    // small buffer, so the status line and headers are split over several reads
+    char buffer[48];
+    HttpPullParser parser;
+    HttpPullEvent event;
+    bool status = false, headers_complete = false, message_complete = false, finished = false;
+    uint32_t body_length = 0;
+
+    while (!message_complete) {
+        switch (parser.next(&event)) {
+            case HTTP_PULL_NEED_DATA: {
+                TEST_ASSERT_FALSE(finished);
+                nsapi_size_or_error_t received = socket.recv(buffer, sizeof(buffer));
+                if (received <= 0) {
+                    parser.finish();
+                    finished = true;
+                }
+                else {
+                    parser.feed(buffer, received);
+                }
+                break;
+            }
+            case HTTP_PULL_STATUS:
+                TEST_ASSERT_EQUAL(200, parser.get_status_code());
+                TEST_ASSERT(event.value.equals("OK"));
+                status = true;
+                break;
+            case HTTP_PULL_HEADER:
+                if (event.name.iequals("content-type")) {
+                    TEST_ASSERT(event.value.equals("application/octet-stream"));
+                }
+                break;
+            case HTTP_PULL_HEADERS_COMPLETE:
+                headers_complete = true;
+                break;
+            case HTTP_PULL_BODY:
+                TEST_ASSERT(headers_complete);
+                body_length += event.value.length;
+                break;
+            case HTTP_PULL_MESSAGE_COMPLETE:
+                message_complete = true;
+                break;
+            default:
+                TEST_FAIL_MESSAGE(http_errno_description(parser.get_error()));
+                break;
+        }
+    }
+
+    TEST_ASSERT(status);
+    TEST_ASSERT_EQUAL(2048, body_length);
+
+    return CaseNext;
+}
+
 static control_t https_get(const size_t call_count) {
     setup_verify_network();
 
@@ -133,6 +1037,27 @@ static control_t https_get(const size_t call_count) {
     return CaseNext;
 }
 
+static control_t https_certificate_store(const size_t call_count) {
+    setup_verify_network();
+
+    CertificateStore ca_store(SSL_CA_PEM);
+    TEST_ASSERT_EQUAL(0, ca_store.get_error());
+    TEST_ASSERT_EQUAL(3, ca_store.get_certificate_count());
+    TEST_ASSERT(ca_store.get_memory_usage() > 0);
+
+    for (size_t ix = 0; ix < 2; ix++) {
+        HttpsRequest *req = new HttpsRequest(network, &ca_store, HTTP_GET, "https://httpbin.org/status/418");
+
+        HttpResponse* res = req->send();
+        TEST_ASSERT(res);
+        TEST_ASSERT_EQUAL(418, res->get_status_code());
+
+        delete req;
+    }
+
+    return CaseNext;
+}
+
 static control_t https_post(const size_t call_count) {
     setup_verify_network();
 
@@ -158,6 +1083,163 @@ static control_t https_post(const size_t call_count) {
     return CaseNext;
 }
 
+static control_t https_session_cache(const size_t call_count) {
+    setup_verify_network();
+
+    TLSSessionCache session_cache;
+
+    for (size_t ix = 0; ix < 2; ix++) {
+        HttpsRequest *req = new HttpsRequest(network, SSL_CA_PEM, HTTP_GET, "https://httpbin.org/status/418");
+        req->set_session_cache(&session_cache);
+
+        HttpResponse* res = req->send();
+        TEST_ASSERT(res);
+        TEST_ASSERT_EQUAL(418, res->get_status_code());
+
+        delete req;
+    }
+
+    // first connection does a full handshake, the second one resumes its session
+    TEST_ASSERT_EQUAL(1, session_cache.get_misses());
+    TEST_ASSERT_EQUAL(1, session_cache.get_hits());
+    TEST_ASSERT_EQUAL(1, session_cache.get_size());
+
+    return CaseNext;
+}
+
+// one direction of an in-memory connection between two TLS contexts
+struct loopback_bio {
+    string* out;
+    string* in;
+    bool held;
+};
+
+static int loopback_send(void* ctx, const unsigned char* buf, size_t len) {
+    loopback_bio* bio = (loopback_bio*)ctx;
+    if (bio->held) {
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+    }
+    bio->out->append((const char*)buf, len);
+    return len;
+}
+
+static int loopback_recv(void* ctx, unsigned char* buf, size_t len) {
+    loopback_bio* bio = (loopback_bio*)ctx;
+    if (bio->in->empty()) {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+    if (len > bio->in->size()) {
+        len = bio->in->size();
+    }
+    memcpy(buf, bio->in->data(), len);
+    bio->in->erase(0, len);
+    return len;
+}
+
+// connects a client to an mbedTLS server in memory, restoring the session the same way TLSSessionSocket does
+static void loopback_connect(mbedtls_ssl_config* client_conf, mbedtls_ssl_config* server_conf, TLSSessionCache* cache) {
+    string to_server, to_client;
+    loopback_bio client_bio = { &to_server, &to_client, false };
+    loopback_bio server_bio = { &to_client, &to_server, false };
+
+    mbedtls_ssl_context client, server;
+    mbedtls_ssl_init(&client);
+    mbedtls_ssl_init(&server);
+    TEST_ASSERT_EQUAL(0, mbedtls_ssl_setup(&client, client_conf));
+    TEST_ASSERT_EQUAL(0, mbedtls_ssl_setup(&server, server_conf));
+    TEST_ASSERT_EQUAL(0, mbedtls_ssl_set_hostname(&client, "localhost"));
+    mbedtls_ssl_set_bio(&client, &client_bio, loopback_send, loopback_recv, NULL);
+    mbedtls_ssl_set_bio(&server, &server_bio, loopback_send, loopback_recv, NULL);
+
+    if (cache->contains("localhost")) {
+        // a held back ClientHello is dropped, the session goes into the next one
+        client_bio.held = true;
+        TEST_ASSERT_EQUAL(MBEDTLS_ERR_SSL_WANT_WRITE, mbedtls_ssl_handshake(&client));
+        client_bio.held = false;
+        TEST_ASSERT_EQUAL(0, mbedtls_ssl_session_reset(&client));
+        TEST_ASSERT_TRUE(cache->restore("localhost", &client));
+    }
+
+    int client_ret = MBEDTLS_ERR_SSL_WANT_READ;
+    int server_ret = MBEDTLS_ERR_SSL_WANT_READ;
+    for (size_t ix = 0; ix < 100 && (client_ret != 0 || server_ret != 0); ix++) {
+        if (client_ret != 0) {
+            client_ret = mbedtls_ssl_handshake(&client);
+        }
+        if (server_ret != 0) {
+            server_ret = mbedtls_ssl_handshake(&server);
+        }
+        TEST_ASSERT(client_ret == 0 || client_ret == MBEDTLS_ERR_SSL_WANT_READ);
+        TEST_ASSERT(server_ret == 0 || server_ret == MBEDTLS_ERR_SSL_WANT_READ);
+    }
+    TEST_ASSERT_EQUAL(0, client_ret);
+    TEST_ASSERT_EQUAL(0, server_ret);
+
+    cache->save("localhost", &client);
+
+    mbedtls_ssl_free(&client);
+    mbedtls_ssl_free(&server);
+}
+
+static control_t tls_session_cache_loopback(const size_t call_count) {
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context ctr_drbg;
+    mbedtls_x509_crt server_crt;
+    mbedtls_pk_context server_key;
+    mbedtls_ssl_cache_context server_cache;
+    mbedtls_ssl_config client_conf, server_conf;
+
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&ctr_drbg);
+    mbedtls_x509_crt_init(&server_crt);
+    mbedtls_pk_init(&server_key);
+    mbedtls_ssl_cache_init(&server_cache);
+    mbedtls_ssl_config_init(&client_conf);
+    mbedtls_ssl_config_init(&server_conf);
+
+    TEST_ASSERT_EQUAL(0, mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy, NULL, 0));
+    TEST_ASSERT_EQUAL(0, mbedtls_x509_crt_parse(&server_crt, (const unsigned char*)mbedtls_test_srv_crt, mbedtls_test_srv_crt_len));
+    TEST_ASSERT_EQUAL(0, mbedtls_pk_parse_key(&server_key, (const unsigned char*)mbedtls_test_srv_key, mbedtls_test_srv_key_len, NULL, 0));
+
+    TEST_ASSERT_EQUAL(0, mbedtls_ssl_config_defaults(&server_conf, MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT));
+    mbedtls_ssl_conf_rng(&server_conf, mbedtls_ctr_drbg_random, &ctr_drbg);
+    TEST_ASSERT_EQUAL(0, mbedtls_ssl_conf_own_cert(&server_conf, &server_crt, &server_key));
+    mbedtls_ssl_conf_session_cache(&server_conf, &server_cache, mbedtls_ssl_cache_get, mbedtls_ssl_cache_set);
+
+    // the certificate is not what's under test here
+    TEST_ASSERT_EQUAL(0, mbedtls_ssl_config_defaults(&client_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT));
+    mbedtls_ssl_conf_rng(&client_conf, mbedtls_ctr_drbg_random, &ctr_drbg);
+    mbedtls_ssl_conf_authmode(&client_conf, MBEDTLS_SSL_VERIFY_NONE);
+
+    TLSSessionCache cache;
+
+    loopback_connect(&client_conf, &server_conf, &cache);
+    TEST_ASSERT_EQUAL(0, cache.get_hits());
+    TEST_ASSERT_EQUAL(1, cache.get_misses());
+
+    loopback_connect(&client_conf, &server_conf, &cache);
+    TEST_ASSERT_EQUAL(1, cache.get_hits());
+    TEST_ASSERT_EQUAL(1, cache.get_misses());
+
+    // the server forgot the session, so the offered session is declined
+    mbedtls_ssl_cache_free(&server_cache);
+    mbedtls_ssl_cache_init(&server_cache);
+
+    loopback_connect(&client_conf, &server_conf, &cache);
+    TEST_ASSERT_EQUAL(1, cache.get_hits());
+    TEST_ASSERT_EQUAL(2, cache.get_misses());
+
+    mbedtls_ssl_config_free(&client_conf);
+    mbedtls_ssl_config_free(&server_conf);
+    mbedtls_ssl_cache_free(&server_cache);
+    mbedtls_pk_free(&server_key);
+    mbedtls_x509_crt_free(&server_crt);
+    mbedtls_ctr_drbg_free(&ctr_drbg);
+    mbedtls_entropy_free(&entropy);
+
+    return CaseNext;
+}
+
 static control_t https_socket_reuse(const size_t call_count) {
     setup_verify_network();
 
@@ -243,11 +1325,36 @@ utest::v1::status_t greentea_setup(const size_t number_of_cases) {
 
 Case cases[] = {
     Case("http get", http_get),
+    Case("http body sink", http_body_sink),
+    Case("http resumable download", http_resumable_download),
+    Case("http resumable download retry", http_resumable_download_retry),
+    Case("http response body growth", http_response_body_growth),
+    Case("http chunked writer", http_chunked_writer),
+    Case("http response cache", http_response_cache),
+    Case("http response cache damaged entry", http_response_cache_damaged),
+    Case("http content decoding", http_content_decoding),
     Case("http post", http_post),
+    Case("http post compressed", http_post_compressed),
+    Case("http get async", http_get_async),
+    Case("http get async queue full", http_get_async_queue_full),
+    Case("http get async cancel", http_get_async_cancel),
+    Case("http multiplexer", http_multiplexer),
+    Case("http segmented download", http_segmented_download),
+    Case("http segmented download unresolvable host", http_segmented_download_unresolvable),
+    Case("http segmented download queue full", http_segmented_download_queue_full),
     Case("http socket reuse", http_socket_reuse),
+    Case("http connection pool", http_connection_pool),
+    Case("http dns cache", http_dns_cache),
+    Case("http buffer pool", http_buffer_pool),
+    Case("http pipelining", http_pipelining),
+    Case("http pipelining head", http_pipelining_head),
+    Case("http pull parser", http_pull_parser),
     Case("https get", https_get),
+    Case("https certificate store", https_certificate_store),
     Case("https post", https_post),
     Case("https socket reuse", https_socket_reuse),
+    Case("https session cache", https_session_cache),
+    Case("tls session cache over loopback", tls_session_cache_loopback),
     Case("chunked request", chunked_request)
 };
 
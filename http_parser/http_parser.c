@@ -274,6 +274,23 @@ static const uint8_t normal_url_char[32] = {
 /* 120  x   121  y   122  z   123  {   124  |   125  }   126  ~   127 del */
         1    |   2    |   4    |   8    |   16   |   32   |   64   |   0, };
 
+/* The tokens[] and normal_url_char[] sets for US-ASCII, split by nibble for
+ * the vectorised scans: byte c is in the set when
+ *
+ *   (xxx_nibbles[c & 0xf] & hi_nibble_bits[c >> 4]) != 0
+ *
+ * Bytes with the top bit set are never matched here and are left to the
+ * byte-wise checks. hi_nibble_bits[] is only needed by the SIMD code and is
+ * defined next to it.
+ */
+static const uint8_t token_nibbles[16] = {
+  0xe8 | T(0x04), 0xfc, 0xf8, 0xfc, 0xfc, 0xfc, 0xfc, 0xfc,
+  0xf8, 0xf8, 0xf4, 0x54, 0xd0, 0x54, 0xf4, 0x70 };
+
+static const uint8_t url_nibbles[16] = {
+  0xf8, 0xfc, 0xfc, 0xf8, 0xfc, 0xfc, 0xfc, 0xfc,
+  0xfc, 0xfc | T(0x01), 0xfc, 0xfc, 0xfc | T(0x01), 0xfc, 0xfc, 0x74 };
+
 #undef T
 
 enum state
@@ -472,6 +489,186 @@ static struct {
 
 int http_message_needs_eof(const http_parser *parser);
 
+/* Vectorised scans for the hot loops of http_parser_execute().
+ *
+ * Each helper returns the first position in [p, end) that the byte-wise state
+ * machine has to look at, i.e. every byte before it leaves the parser in its
+ * current state. The SIMD code only skips whole 16-byte blocks and the scalar
+ * loops settle the last few bytes, so the result is the same as scanning one
+ * byte at a time.
+ *
+ * SSE2 is part of x86-64 and is used whenever the compiler targets it. SSSE3
+ * (for the set lookups) is picked at compile time when enabled, otherwise it
+ * is detected at run time on GCC/Clang x86-64 builds. AArch64 always has
+ * NEON. Everything else, including the Cortex-M targets, uses the scalar and
+ * word-at-a-time paths.
+ */
+#if HTTP_PARSER_SIMD && (defined(__SSE2__) || defined(_M_X64))
+# include <emmintrin.h>
+# define HTTP_PARSER_SSE2 1
+#endif
+
+#if HTTP_PARSER_SIMD && defined(__SSSE3__)
+# include <tmmintrin.h>
+# define HTTP_PARSER_SSSE3 1
+# define HTTP_PARSER_SSSE3_TARGET
+#elif HTTP_PARSER_SIMD && defined(__x86_64__) && \
+      (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+# include <tmmintrin.h>
+# define HTTP_PARSER_SSSE3 1
+# define HTTP_PARSER_SSSE3_DISPATCH 1
+# define HTTP_PARSER_SSSE3_TARGET __attribute__((target("ssse3")))
+#endif
+
+#if HTTP_PARSER_SIMD && defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+# define HTTP_PARSER_NEON 1
+#endif
+
+#if HTTP_PARSER_SSSE3 || HTTP_PARSER_NEON
+static const uint8_t hi_nibble_bits[16] = {
+  1, 2, 4, 8, 16, 32, 64, 128, 0, 0, 0, 0, 0, 0, 0, 0 };
+#endif
+
+/* Find the first CR or LF in [p, end), or end */
+static const char*
+find_crlf(const char* p, const char* end)
+{
+#if HTTP_PARSER_SSE2
+  const __m128i cr = _mm_set1_epi8(CR);
+  const __m128i lf = _mm_set1_epi8(LF);
+
+  for (; end - p >= 16; p += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*) p);
+    __m128i eol = _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf));
+    if (_mm_movemask_epi8(eol))
+      break;
+  }
+#elif HTTP_PARSER_NEON
+  const uint8x16_t cr = vdupq_n_u8(CR);
+  const uint8x16_t lf = vdupq_n_u8(LF);
+
+  for (; end - p >= 16; p += 16) {
+    uint8x16_t v = vld1q_u8((const uint8_t*) p);
+    if (vmaxvq_u8(vorrq_u8(vceqq_u8(v, cr), vceqq_u8(v, lf))))
+      break;
+  }
+#else
+  /* A zero byte in w ^ (CR repeated) marks a CR, same for LF */
+  const size_t ones = ((size_t) -1) / 0xff;
+  const size_t highs = ones * 0x80;
+
+  for (; (size_t) (end - p) >= sizeof(size_t); p += sizeof(size_t)) {
+    size_t w, w_cr, w_lf;
+    memcpy(&w, p, sizeof(w));
+    w_cr = w ^ (ones * CR);
+    w_lf = w ^ (ones * LF);
+    if (((w_cr - ones) & ~w_cr & highs) | ((w_lf - ones) & ~w_lf & highs))
+      break;
+  }
+#endif
+
+  while (p != end && *p != CR && *p != LF)
+    p++;
+
+  return p;
+}
+
+#if HTTP_PARSER_SSSE3
+HTTP_PARSER_SSSE3_TARGET
+static const char*
+skip_nibble_set_ssse3(const char* p, const char* end, const uint8_t* nibbles)
+{
+  const __m128i lo_table = _mm_loadu_si128((const __m128i*) nibbles);
+  const __m128i hi_table = _mm_loadu_si128((const __m128i*) hi_nibble_bits);
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  const __m128i zero = _mm_setzero_si128();
+
+  for (; end - p >= 16; p += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*) p);
+    __m128i lo = _mm_shuffle_epi8(lo_table, _mm_and_si128(v, mask));
+    __m128i hi = _mm_shuffle_epi8(hi_table,
+                                  _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), zero)))
+      break;
+  }
+
+  return p;
+}
+#endif
+
+/* Skip whole 16-byte blocks whose bytes are all in the nibble set */
+static const char*
+skip_nibble_set(const char* p, const char* end, const uint8_t* nibbles)
+{
+#if HTTP_PARSER_SSSE3_DISPATCH
+  static int has_ssse3 = -1;
+
+  if (UNLIKELY(has_ssse3 < 0)) {
+    __builtin_cpu_init();
+    has_ssse3 = __builtin_cpu_supports("ssse3") ? 1 : 0;
+  }
+  if (has_ssse3)
+    p = skip_nibble_set_ssse3(p, end, nibbles);
+#elif HTTP_PARSER_SSSE3
+  p = skip_nibble_set_ssse3(p, end, nibbles);
+#elif HTTP_PARSER_NEON
+  const uint8x16_t lo_table = vld1q_u8(nibbles);
+  const uint8x16_t hi_table = vld1q_u8(hi_nibble_bits);
+  const uint8x16_t mask = vdupq_n_u8(0x0f);
+
+  for (; end - p >= 16; p += 16) {
+    uint8x16_t v = vld1q_u8((const uint8_t*) p);
+    uint8x16_t lo = vqtbl1q_u8(lo_table, vandq_u8(v, mask));
+    uint8x16_t hi = vqtbl1q_u8(hi_table, vshrq_n_u8(v, 4));
+    if (vminvq_u8(vandq_u8(lo, hi)) == 0)
+      break;
+  }
+#else
+  (void) end;
+  (void) nibbles;
+#endif
+
+  return p;
+}
+
+/* Find the first byte in [p, end) that is not a header field token char */
+static const char*
+skip_token_chars(const char* p, const char* end)
+{
+  p = skip_nibble_set(p, end, token_nibbles);
+  while (p != end && TOKEN(*p))
+    p++;
+
+  return p;
+}
+
+/* Find the first byte in [p, end) that is not a URL char */
+static const char*
+skip_url_chars(const char* p, const char* end)
+{
+  p = skip_nibble_set(p, end, url_nibbles);
+  while (p != end && IS_URL_CHAR(*p))
+    p++;
+
+  return p;
+}
+
+/* Limit a skip from p so that it stops before the byte that would push
+ * the header size over HTTP_MAX_HEADER_SIZE; that byte still goes through
+ * COUNT_HEADER_SIZE(1) in the main loop and fails exactly as before.
+ */
+static const char*
+header_scan_end(const http_parser* parser, const char* p, const char* end)
+{
+  uint32_t budget = HTTP_MAX_HEADER_SIZE - parser->nread;
+
+  if ((size_t) (end - p) > budget)
+    return p + budget;
+
+  return end;
+}
+
 /* Our URL parser.
  *
  * This is designed to be shared by http_parser_execute() for URL validation,
@@ -779,6 +976,26 @@ reexecute:
       }
 
       case s_res_H:
+        /* Fast path for a status line that starts with "HTTP/x.y nnn " and
+         * is complete in this buffer, s_res_status picks up the reason
+         * phrase. Anything else, including a line split over two reads,
+         * goes through the byte-wise states below.
+         */
+        if (data + len - p >= 12 &&
+            header_scan_end(parser, p, data + len) - p >= 11 &&
+            memcmp(p, "TTP/", 4) == 0 &&
+            IS_NUM(p[4]) && p[5] == '.' && IS_NUM(p[6]) && p[7] == ' ' &&
+            IS_NUM(p[8]) && IS_NUM(p[9]) && IS_NUM(p[10]) && p[11] == ' ') {
+          parser->http_major = p[4] - '0';
+          parser->http_minor = p[6] - '0';
+          parser->status_code = (p[8] - '0') * 100 + (p[9] - '0') * 10 +
+                                (p[10] - '0');
+          COUNT_HEADER_SIZE(11);
+          p += 11;
+          UPDATE_STATE(s_res_status_start);
+          break;
+        }
+
         STRICT_CHECK(ch != 'T');
         UPDATE_STATE(s_res_HT);
         break;
@@ -922,8 +1139,8 @@ reexecute:
         // no reason phrase is following - store status code
         if (ch == CR) {
           MARK(status);
-          CALLBACK_DATA(status);
           UPDATE_STATE(s_res_line_almost_done);
+          CALLBACK_DATA(status);
           break;
         }
 
@@ -951,6 +1168,12 @@ reexecute:
           break;
         }
 
+        {
+          const char* eol =
+            find_crlf(p + 1, header_scan_end(parser, p + 1, data + len));
+          COUNT_HEADER_SIZE(eol - (p + 1));
+          p = eol - 1;
+        }
         break;
 
       case s_res_line_almost_done:
@@ -1126,6 +1349,16 @@ reexecute:
               SET_ERRNO(HPE_INVALID_URL);
               goto error;
             }
+
+            /* URL chars don't change these states, skip ahead */
+            if (CURRENT_STATE() == s_req_path ||
+                CURRENT_STATE() == s_req_query_string ||
+                CURRENT_STATE() == s_req_fragment) {
+              const char* q = skip_url_chars(p + 1,
+                  header_scan_end(parser, p + 1, data + len));
+              COUNT_HEADER_SIZE(q - (p + 1));
+              p = q - 1;
+            }
         }
         break;
       }
@@ -1314,6 +1547,7 @@ reexecute:
 
           switch (parser->header_state) {
             case h_general:
+              p = skip_token_chars(p + 1, data + len) - 1;
               break;
 
             case h_C:
@@ -1541,24 +1775,14 @@ reexecute:
           switch (h_state) {
             case h_general:
             {
-              const char* p_cr;
-              const char* p_lf;
-              uint32_t limit = data + len - p;
-
-              limit = MIN(limit, HTTP_MAX_HEADER_SIZE);
-
-              p_cr = (const char*) memchr(p, CR, limit);
-              p_lf = (const char*) memchr(p, LF, limit);
-              if (p_cr != NULL) {
-                if (p_lf != NULL && p_cr >= p_lf)
-                  p = p_lf;
-                else
-                  p = p_cr;
-              } else if (UNLIKELY(p_lf != NULL)) {
-                p = p_lf;
-              } else {
-                p = data + len;
-              }
+              const char* limit = data + len;
+              const char* eol;
+
+              if (limit - p > HTTP_MAX_HEADER_SIZE)
+                limit = p + HTTP_MAX_HEADER_SIZE;
+
+              eol = find_crlf(p, limit);
+              p = (eol != limit) ? eol : data + len;
               --p;
 
               break;
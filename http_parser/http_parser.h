@@ -53,6 +53,14 @@ typedef unsigned __int64 uint64_t;
 # define HTTP_PARSER_STRICT 1
 #endif
 
+/* Compile with -DHTTP_PARSER_SIMD=0 to scan header fields, header values,
+ * URLs and status text one byte at a time instead of with SSE2/SSSE3 or
+ * NEON. The results are the same either way.
+ */
+#ifndef HTTP_PARSER_SIMD
+# define HTTP_PARSER_SIMD 1
+#endif
+
 /* Maximium header size allowed. If the macro is not defined
  * before including this header then the default is used. To
  * change the maximum header size, define the macro in the build
@@ -42,7 +42,6 @@ private:
 	std::string boundary;
 	const char *boundaryData;
 	size_t boundarySize;
-	bool boundaryIndex[256];
 	char *lookbehind;
 	size_t lookbehindSize;
 	State _state;
@@ -65,17 +64,6 @@ private:
 		userData      = NULL;
 	}
 	
-	void indexBoundary() {
-		const char *current;
-		const char *end = boundaryData + boundarySize;
-		
-		memset(boundaryIndex, 0, sizeof(boundaryIndex));
-		
-		for (current = boundaryData; current < end; current++) {
-			boundaryIndex[(unsigned char) *current] = true;
-		}
-	}
-	
 	void callback(Callback cb, const char *buffer = NULL, size_t start = UNMARKED,
 		size_t end = UNMARKED, bool allowEmpty = false)
 	{
@@ -107,10 +95,6 @@ private:
 		return c | 0x20;
 	}
 	
-	inline bool isBoundaryChar(char c) const {
-		return boundaryIndex[(unsigned char) c];
-	}
-	
 	bool isHeaderFieldCharacter(char c) const {
 		return (c >= 'a' && c <= 'z')
 			|| (c >= 'A' && c <= 'Z')
@@ -123,23 +107,41 @@ private:
 	}
 	
 	void processPartData(size_t &prevIndex, size_t &index, const char *buffer,
-		size_t len, size_t boundaryEnd, size_t &i, char c, State &state, int &flags)
+		size_t len, size_t &i, char c, State &state, int &flags)
 	{
 		prevIndex = index;
 		
 		if (index == 0) {
-			// boyer-moore derived algorithm to safely skip non-boundary data
-			while (i + boundarySize <= len) {
-				if (isBoundaryChar(buffer[i + boundaryEnd])) {
+			// jump from CR to CR and compare the whole boundary in place, so part
+			// data is handed out in one span and false leads need no lookbehind
+			const char *p = buffer + i;
+			const char *end = buffer + len;
+			size_t avail = 0;
+			
+			while ((p = (const char *) memchr(p, CR, end - p)) != NULL) {
+				avail = end - p;
+				if (avail >= boundarySize) {
+					if (memcmp(p, boundaryData, boundarySize) == 0) {
+						break;
+					}
+				} else if (memcmp(p, boundaryData, avail) == 0) {
 					break;
 				}
-				
-				i += boundarySize;
+				p++;
 			}
-			if (i == len) {
+			
+			if (p == NULL) {
+				i = len - 1;
 				return;
 			}
-			c = buffer[i];
+			
+			i = p - buffer;
+			dataCallback(onPartData, partDataMark, buffer, i, len, true);
+			
+			// lookbehind already starts with the boundary, see setBoundary()
+			index = avail < boundarySize ? avail : boundarySize;
+			i += index - 1;
+			return;
 		}
 		
 		if (index < boundarySize) {
@@ -277,9 +279,9 @@ public:
 		this->boundary = "\r\n--" + boundary;
 		boundaryData = this->boundary.c_str();
 		boundarySize = this->boundary.size();
-		indexBoundary();
 		lookbehind = new char[boundarySize + 8];
 		lookbehindSize = boundarySize + 8;
+		memcpy(lookbehind, boundaryData, boundarySize);
 		this->_state = START;
 		errorReason = "No error.";
 	}
@@ -327,7 +329,6 @@ public:
 		}
 		
 		size_t prevIndex    = this->_index;
-		size_t boundaryEnd  = boundarySize - 1;
 		size_t i;
 		char c, cl;
 		
@@ -432,7 +433,7 @@ public:
 				this->_state = PART_DATA;
 				partDataMark = i;
 			case PART_DATA:
-				processPartData(prevIndex, this->_index, buffer, len, boundaryEnd, i, c, this->_state, this->_flags);
+				processPartData(prevIndex, this->_index, buffer, len, i, c, this->_state, this->_flags);
 				break;
 			default:
 				return i;
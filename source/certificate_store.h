@@ -0,0 +1,132 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MBED_HTTP_CERTIFICATE_STORE_H_
+#define _MBED_HTTP_CERTIFICATE_STORE_H_
+
+#include "mbed.h"
+#include "TLSSocket.h"
+#include "mbedtls/x509_crt.h"
+
+/**
+ * \brief CertificateStore holds a parsed chain of trusted root CA certificates.
+ *
+ * The PEM bundle is parsed once, in the constructor. After that the chain is not modified,
+ * so one store can be attached to any number of TLSSocket / HttpsRequest objects at the same time.
+ * The store needs to outlive all sockets it's attached to.
+ */
+class CertificateStore {
+public:
+    /**
+     * CertificateStore Constructor
+     *
+     * @param[in] ssl_ca_pem String containing the trusted CAs (one or more PEM certificates)
+     */
+    CertificateStore(const char* ssl_ca_pem) {
+        mbedtls_x509_crt_init(&_chain);
+
+        // mbedtls wants the length including the terminating NULL byte for PEM input
+        _error = mbedtls_x509_crt_parse(&_chain, (const unsigned char*)ssl_ca_pem, strlen(ssl_ca_pem) + 1);
+    }
+
+    ~CertificateStore() {
+        mbedtls_x509_crt_free(&_chain);
+    }
+
+    /**
+     * Get the parse result: 0 when all certificates were parsed, a negative mbedtls error code
+     * when parsing failed, or the number of certificates that could not be parsed.
+     */
+    int get_error() const {
+        return _error;
+    }
+
+    /**
+     * Get the parsed chain. Don't modify it, it's shared between sockets.
+     */
+    mbedtls_x509_crt* get_chain() {
+        return &_chain;
+    }
+
+    /**
+     * Use the certificates in this store as trusted CAs for a socket.
+     * Call this instead of TLSSocketWrapper::set_root_ca_cert, before connecting.
+     */
+    void attach(TLSSocketWrapper* socket) {
+        socket->set_ca_chain(&_chain);
+    }
+
+    /**
+     * Number of certificates in the store.
+     */
+    uint32_t get_certificate_count() const {
+        uint32_t count = 0;
+        for (const mbedtls_x509_crt* crt = &_chain; crt != NULL && crt->raw.len > 0; crt = crt->next) {
+            count++;
+        }
+        return count;
+    }
+
+    /**
+     * Heap used by the parsed certificates in bytes: the certificate structures, their DER
+     * encoding (every certificate keeps its own copy) and the parsed issuer, subject and
+     * extension lists. The public key contexts are not included, they add about 100 to 300
+     * bytes per certificate, depending on the key type.
+     */
+    uint32_t get_memory_usage() const {
+        uint32_t size = 0;
+        for (const mbedtls_x509_crt* crt = &_chain; crt != NULL && crt->raw.len > 0; crt = crt->next) {
+            // the first structure is a member of this object, every next one is on the heap
+            if (crt != &_chain) {
+                size += sizeof(mbedtls_x509_crt);
+            }
+            size += crt->raw.len;
+            size += get_name_usage(&crt->issuer);
+            size += get_name_usage(&crt->subject);
+            size += get_sequence_usage(&crt->subject_alt_names);
+            size += get_sequence_usage(&crt->ext_key_usage);
+        }
+        return size;
+    }
+
+private:
+    // not copyable, sockets keep a pointer to the chain
+    CertificateStore(const CertificateStore&);
+    CertificateStore& operator=(const CertificateStore&);
+
+    // the first entry of these lists is part of the certificate structure, the rest is allocated while parsing
+    static uint32_t get_name_usage(const mbedtls_x509_name* name) {
+        uint32_t size = 0;
+        for (name = name->next; name != NULL; name = name->next) {
+            size += sizeof(mbedtls_x509_name);
+        }
+        return size;
+    }
+
+    static uint32_t get_sequence_usage(const mbedtls_x509_sequence* sequence) {
+        uint32_t size = 0;
+        for (sequence = sequence->next; sequence != NULL; sequence = sequence->next) {
+            size += sizeof(mbedtls_x509_sequence);
+        }
+        return size;
+    }
+
+    mbedtls_x509_crt _chain;
+    int _error;
+};
+
+#endif // _MBED_HTTP_CERTIFICATE_STORE_H_
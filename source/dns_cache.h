@@ -0,0 +1,240 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MBED_HTTP_DNS_CACHE_H_
+#define _MBED_HTTP_DNS_CACHE_H_
+
+#include <string>
+#include <vector>
+#include "mbed.h"
+#include "NetworkInterface.h"
+
+#ifndef HTTP_DNS_CACHE_SIZE
+#define HTTP_DNS_CACHE_SIZE 8
+#endif
+
+#ifndef HTTP_DNS_CACHE_TTL
+#define HTTP_DNS_CACHE_TTL 300000
+#endif
+
+#ifndef HTTP_DNS_CACHE_NEGATIVE_TTL
+#define HTTP_DNS_CACHE_NEGATIVE_TTL 10000
+#endif
+
+using namespace std;
+
+/**
+ * \brief DnsCache remembers host name lookups, so repeated requests to the same host don't hit the resolver.
+ *
+ * The network stack does not expose the TTL of a DNS record, so entries expire after a fixed time.
+ * Failed lookups are cached as well (for a shorter time), so an unreachable host doesn't
+ * block every request on a resolver timeout.
+ *
+ * A cache can be shared between requests and between threads.
+ */
+class DnsCache {
+public:
+    /**
+     * DnsCache Constructor
+     *
+     * @param[in] max_entries Maximum number of hosts kept
+     * @param[in] ttl_ms How long a resolved address is used, in milliseconds
+     * @param[in] negative_ttl_ms How long a failed lookup is remembered, in milliseconds (0 disables negative caching)
+     */
+    DnsCache(uint32_t max_entries = HTTP_DNS_CACHE_SIZE,
+             uint32_t ttl_ms = HTTP_DNS_CACHE_TTL,
+             uint32_t negative_ttl_ms = HTTP_DNS_CACHE_NEGATIVE_TTL)
+        : _max_entries(max_entries), _ttl_ms(ttl_ms), _negative_ttl_ms(negative_ttl_ms),
+          _queue(NULL), _hits(0), _misses(0)
+    {}
+
+    /**
+     * Refresh entries in the background before they expire.
+     * When an entry that is in the last quarter of its lifetime is used, a new lookup is
+     * posted to the queue, and the cached address is returned right away.
+     *
+     * @param queue Queue to run the lookups on (NULL disables refreshing), needs to outlive the cache
+     */
+    void set_refresh_queue(EventQueue* queue) {
+        _queue = queue;
+    }
+
+    /**
+     * Resolve a host name, using the cache if there is a valid entry.
+     *
+     * @param network Network interface to use for the lookup
+     * @param host Host name
+     * @param address Destination for the address (port is not touched)
+     * @return NSAPI_ERROR_OK on success, or the (cached) error of the lookup
+     */
+    nsapi_error_t resolve(NetworkInterface* network, const char* host, SocketAddress* address) {
+        uint64_t now = Kernel::get_ms_count();
+        bool refresh = false;
+
+        _mutex.lock();
+        int ix = find(host);
+        if (ix >= 0 && now < _entries[ix].expires) {
+            Entry& entry = _entries[ix];
+            nsapi_error_t result = entry.result;
+
+            if (result == NSAPI_ERROR_OK) {
+                address->set_ip_address(entry.address.get_ip_address());
+
+                if (_queue && !entry.refreshing && entry.expires - now < _ttl_ms / 4) {
+                    entry.refreshing = true;
+                    refresh = true;
+                }
+            }
+            _hits++;
+            _mutex.unlock();
+
+            if (refresh && _queue->call(this, &DnsCache::refresh, network, string(host)) == 0) {
+                // queue is full, try again on the next hit
+                _mutex.lock();
+                ix = find(host);
+                if (ix >= 0) {
+                    _entries[ix].refreshing = false;
+                }
+                _mutex.unlock();
+            }
+            return result;
+        }
+        _misses++;
+        _mutex.unlock();
+
+        // don't hold the lock during the lookup, it can take seconds
+        SocketAddress resolved;
+        nsapi_error_t result = network->gethostbyname(host, &resolved);
+        store(host, result, resolved);
+
+        if (result == NSAPI_ERROR_OK) {
+            address->set_ip_address(resolved.get_ip_address());
+        }
+        return result;
+    }
+
+    /**
+     * Remove a host from the cache, e.g. when connecting to the cached address failed.
+     */
+    void invalidate(const char* host) {
+        _mutex.lock();
+        int ix = find(host);
+        if (ix >= 0) {
+            _entries.erase(_entries.begin() + ix);
+        }
+        _mutex.unlock();
+    }
+
+    /**
+     * Remove all hosts from the cache.
+     */
+    void clear() {
+        _mutex.lock();
+        _entries.clear();
+        _mutex.unlock();
+    }
+
+    /**
+     * Number of lookups answered from the cache.
+     */
+    uint32_t get_hits() {
+        return _hits;
+    }
+
+    /**
+     * Number of lookups that went to the resolver.
+     */
+    uint32_t get_misses() {
+        return _misses;
+    }
+
+private:
+    struct Entry {
+        string host;
+        SocketAddress address;
+        nsapi_error_t result;
+        uint64_t expires;
+        bool refreshing;
+    };
+
+    int find(const char* host) {
+        for (size_t ix = 0; ix < _entries.size(); ix++) {
+            if (_entries[ix].host == host) {
+                return ix;
+            }
+        }
+        return -1;
+    }
+
+    void store(const char* host, nsapi_error_t result, const SocketAddress& address) {
+        uint32_t ttl = result == NSAPI_ERROR_OK ? _ttl_ms : _negative_ttl_ms;
+
+        _mutex.lock();
+        int ix = find(host);
+        if (ix >= 0) {
+            _entries.erase(_entries.begin() + ix);
+        }
+
+        if (ttl > 0) {
+            // entries are in insertion order, drop the oldest one when full
+            while (_entries.size() >= _max_entries && _entries.size() > 0) {
+                _entries.erase(_entries.begin());
+            }
+
+            Entry entry;
+            entry.host = host;
+            entry.address = address;
+            entry.result = result;
+            entry.expires = Kernel::get_ms_count() + ttl;
+            entry.refreshing = false;
+            _entries.push_back(entry);
+        }
+        _mutex.unlock();
+    }
+
+    void refresh(NetworkInterface* network, string host) {
+        SocketAddress resolved;
+        nsapi_error_t result = network->gethostbyname(host.c_str(), &resolved);
+
+        // keep serving the old address if the refresh failed, it expires normally
+        if (result == NSAPI_ERROR_OK) {
+            store(host.c_str(), result, resolved);
+        }
+        else {
+            _mutex.lock();
+            int ix = find(host.c_str());
+            if (ix >= 0) {
+                _entries[ix].refreshing = false;
+            }
+            _mutex.unlock();
+        }
+    }
+
+    uint32_t _max_entries;
+    uint32_t _ttl_ms;
+    uint32_t _negative_ttl_ms;
+
+    EventQueue* _queue;
+
+    uint32_t _hits;
+    uint32_t _misses;
+
+    vector<Entry> _entries;
+    PlatformMutex _mutex;
+};
+
+#endif // _MBED_HTTP_DNS_CACHE_H_
@@ -0,0 +1,815 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MBED_HTTP_BODY_SINK_H_
+#define _MBED_HTTP_BODY_SINK_H_
+
+#include <stdio.h>
+#include <unistd.h>
+#include "mbed.h"
+#include "BlockDevice.h"
+#include "FileSystem.h"
+#include "File.h"
+#include "http_response.h"
+
+#ifndef HTTP_BODY_SINK_BLOCK_SIZE
+#define HTTP_BODY_SINK_BLOCK_SIZE 512
+#endif
+
+/**
+ * \brief BodySink receives the response body of a request, straight from the receive buffer.
+ *
+ * Attach a sink to a request with HttpRequestBase::set_body_sink(). Implement write() (and optionally finish())
+ * to store the body anywhere. The first error a sink returns is kept, and reported by the request after the
+ * response was received; the body that follows it is discarded.
+ */
+class BodySink {
+public:
+    BodySink() : _error(NSAPI_ERROR_OK), _bytes_written(0)
+    {}
+
+    virtual ~BodySink() {}
+
+    /**
+     * Store a part of the body. The data is only valid during the call.
+     *
+     * @return NSAPI_ERROR_OK, or a negative error code
+     */
+    virtual nsapi_error_t write(const char* data, uint32_t size) = 0;
+
+    /**
+     * Called once the complete body was written, e.g. to flush buffered data.
+     *
+     * @return NSAPI_ERROR_OK, or a negative error code
+     */
+    virtual nsapi_error_t finish() {
+        return NSAPI_ERROR_OK;
+    }
+
+    /**
+     * Store everything written so far, without finishing. Used to checkpoint a resumable download.
+     * Sinks that cannot continue after this return NSAPI_ERROR_UNSUPPORTED.
+     *
+     * @return NSAPI_ERROR_OK, or a negative error code
+     */
+    virtual nsapi_error_t flush() {
+        return NSAPI_ERROR_OK;
+    }
+
+    /**
+     * Throw away everything written so far, the next write() starts at the beginning again.
+     * Used when a download has to start over. Sinks that cannot do this return NSAPI_ERROR_UNSUPPORTED.
+     *
+     * @return NSAPI_ERROR_OK, or a negative error code
+     */
+    virtual nsapi_error_t rewind() {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+    /**
+     * Start over: rewind() the sink, and clear the error and the number of bytes written.
+     *
+     * @return NSAPI_ERROR_OK, or the error of rewind()
+     */
+    nsapi_error_t restart() {
+        nsapi_error_t ret = rewind();
+        if (ret == NSAPI_ERROR_OK) {
+            _error = NSAPI_ERROR_OK;
+            _bytes_written = 0;
+        }
+        return ret;
+    }
+
+    /**
+     * Body callback, used by the request. Forwards to write() until an error occurs.
+     */
+    void on_body(const char* at, uint32_t length) {
+        if (_error != NSAPI_ERROR_OK) {
+            return;
+        }
+
+        nsapi_error_t ret = write(at, length);
+        if (ret < 0) {
+            _error = ret;
+            return;
+        }
+
+        _bytes_written += length;
+    }
+
+    /**
+     * Finish the sink, unless writing to it already failed. Used by the request.
+     *
+     * @return NSAPI_ERROR_OK, or the first error that occurred
+     */
+    nsapi_error_t complete() {
+        if (_error == NSAPI_ERROR_OK) {
+            _error = finish();
+        }
+        return _error;
+    }
+
+    /**
+     * The first error that occurred, or NSAPI_ERROR_OK.
+     */
+    nsapi_error_t get_error() {
+        return _error;
+    }
+
+    /**
+     * Number of body bytes that were written to the sink.
+     */
+    uint32_t get_bytes_written() {
+        return _bytes_written;
+    }
+
+protected:
+    nsapi_error_t _error;
+    uint32_t _bytes_written;
+};
+
+/**
+ * \brief MemoryBodySink keeps the body in a heap buffer that grows geometrically.
+ */
+class MemoryBodySink : public BodySink {
+public:
+    /**
+     * MemoryBodySink Constructor
+     *
+     * @param[in] max_size Maximum body size, larger bodies fail with NSAPI_ERROR_NO_MEMORY (0 for no limit)
+     */
+    MemoryBodySink(uint32_t max_size = 0)
+        : _data(NULL), _size(0), _capacity(0), _max_size(max_size)
+    {}
+
+    virtual ~MemoryBodySink() {
+        free(_data);
+    }
+
+    virtual nsapi_error_t write(const char* data, uint32_t size) {
+        if (_max_size != 0 && _size + size > _max_size) {
+            return NSAPI_ERROR_NO_MEMORY;
+        }
+
+        if (_size + size > _capacity) {
+            uint32_t capacity = _capacity == 0 ? HTTP_RESPONSE_BODY_INITIAL_SIZE : _capacity;
+            while (capacity < _size + size) {
+                capacity *= 2;
+            }
+            if (_max_size != 0 && capacity > _max_size) {
+                capacity = _max_size;
+            }
+
+            char* new_data = (char*)realloc(_data, capacity);
+            if (!new_data) {
+                return NSAPI_ERROR_NO_MEMORY;
+            }
+            _data = new_data;
+            _capacity = capacity;
+        }
+
+        memcpy(_data + _size, data, size);
+        _size += size;
+        return NSAPI_ERROR_OK;
+    }
+
+    virtual nsapi_error_t rewind() {
+        _size = 0;
+        return NSAPI_ERROR_OK;
+    }
+
+    const char* get_data() {
+        return _data;
+    }
+
+    uint32_t get_size() {
+        return _size;
+    }
+
+private:
+    char* _data;
+    uint32_t _size;
+    uint32_t _capacity;
+    uint32_t _max_size;
+};
+
+/**
+ * \brief RingBufferBodySink keeps the body in a fixed-size ring buffer, from which another thread can read it.
+ *
+ * The sink never blocks the request: data that does not fit in the buffer is dropped, and counted
+ * (see get_dropped()). Size the buffer for the rate at which the consumer reads.
+ */
+class RingBufferBodySink : public BodySink {
+public:
+    /**
+     * RingBufferBodySink Constructor
+     *
+     * @param[in] capacity Size of the ring buffer in bytes
+     */
+    RingBufferBodySink(uint32_t capacity)
+        : _capacity(capacity), _head(0), _tail(0), _available(0), _dropped(0)
+    {
+        _buffer = (char*)malloc(capacity);
+    }
+
+    virtual ~RingBufferBodySink() {
+        free(_buffer);
+    }
+
+    virtual nsapi_error_t write(const char* data, uint32_t size) {
+        if (!_buffer) {
+            return NSAPI_ERROR_NO_MEMORY;
+        }
+
+        _mutex.lock();
+
+        uint32_t free_space = _capacity - _available;
+        if (size > free_space) {
+            _dropped += size - free_space;
+            size = free_space;
+        }
+
+        // at most two copies, before and after the wrap
+        while (size > 0) {
+            uint32_t len = _capacity - _head < size ? _capacity - _head : size;
+            memcpy(_buffer + _head, data, len);
+            _head = (_head + len) % _capacity;
+            _available += len;
+            data += len;
+            size -= len;
+        }
+
+        _mutex.unlock();
+        return NSAPI_ERROR_OK;
+    }
+
+    /**
+     * Take data out of the ring buffer. Safe to call from another thread while the request runs.
+     *
+     * @return Number of bytes copied into buffer
+     */
+    uint32_t read(char* buffer, uint32_t size) {
+        _mutex.lock();
+
+        if (size > _available) {
+            size = _available;
+        }
+
+        uint32_t read = 0;
+        while (read < size) {
+            uint32_t len = _capacity - _tail < size - read ? _capacity - _tail : size - read;
+            memcpy(buffer + read, _buffer + _tail, len);
+            _tail = (_tail + len) % _capacity;
+            _available -= len;
+            read += len;
+        }
+
+        _mutex.unlock();
+        return read;
+    }
+
+    /**
+     * Number of bytes that can be read.
+     */
+    uint32_t get_available() {
+        _mutex.lock();
+        uint32_t available = _available;
+        _mutex.unlock();
+        return available;
+    }
+
+    /**
+     * Number of body bytes that were dropped because the buffer was full.
+     */
+    uint32_t get_dropped() {
+        _mutex.lock();
+        uint32_t dropped = _dropped;
+        _mutex.unlock();
+        return dropped;
+    }
+
+private:
+    char* _buffer;
+    uint32_t _capacity;
+    uint32_t _head;
+    uint32_t _tail;
+    uint32_t _available;
+    uint32_t _dropped;
+    PlatformMutex _mutex;
+};
+
+/**
+ * \brief BlockBodySink batches the body into blocks of a fixed size before handing it to storage.
+ *
+ * Data is collected in a block-sized staging buffer. When the staging buffer is empty and at least
+ * a full block arrives, the whole blocks are written straight from the receive buffer, without copying.
+ * The last, partial block is written by finish().
+ */
+class BlockBodySink : public BodySink {
+public:
+    /**
+     * BlockBodySink Constructor
+     *
+     * @param[in] block_size Size of the writes handed to storage (except for the last one)
+     */
+    BlockBodySink(uint32_t block_size = HTTP_BODY_SINK_BLOCK_SIZE)
+        : _block(NULL), _block_size(block_size), _block_ix(0), _block_writes(0)
+    {}
+
+    virtual ~BlockBodySink() {
+        free(_block);
+    }
+
+    virtual nsapi_error_t write(const char* data, uint32_t size) {
+        while (size > 0) {
+            if (_block_ix == 0 && size >= _block_size) {
+                uint32_t len = size - (size % _block_size);
+                nsapi_error_t ret = write_blocks(data, len);
+                if (ret < 0) return ret;
+
+                data += len;
+                size -= len;
+                continue;
+            }
+
+            if (!_block) {
+                _block = (char*)malloc(_block_size);
+                if (!_block) {
+                    return NSAPI_ERROR_NO_MEMORY;
+                }
+            }
+
+            uint32_t len = _block_size - _block_ix < size ? _block_size - _block_ix : size;
+            memcpy(_block + _block_ix, data, len);
+            _block_ix += len;
+            data += len;
+            size -= len;
+
+            if (_block_ix == _block_size) {
+                _block_ix = 0;
+                nsapi_error_t ret = write_blocks(_block, _block_size);
+                if (ret < 0) return ret;
+            }
+        }
+
+        return NSAPI_ERROR_OK;
+    }
+
+    virtual nsapi_error_t finish() {
+        return write_partial_block();
+    }
+
+    virtual nsapi_error_t flush() {
+        return write_partial_block();
+    }
+
+    virtual nsapi_error_t rewind() {
+        _block_ix = 0;
+        return rewind_storage();
+    }
+
+    /**
+     * Number of writes handed to storage.
+     */
+    uint32_t get_block_writes() {
+        return _block_writes;
+    }
+
+protected:
+    /**
+     * Write data to storage. size is a multiple of the block size, except for the last write.
+     */
+    virtual nsapi_error_t write_storage(const char* data, uint32_t size) = 0;
+
+    /**
+     * Make sure everything written so far is stored.
+     */
+    virtual nsapi_error_t sync() {
+        return NSAPI_ERROR_OK;
+    }
+
+    /**
+     * Go back to the start of the storage, see BodySink::rewind().
+     */
+    virtual nsapi_error_t rewind_storage() {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+private:
+    // writes the staged part of a block (the last write can be smaller than a block), then syncs
+    nsapi_error_t write_partial_block() {
+        if (_block_ix > 0) {
+            uint32_t len = _block_ix;
+            _block_ix = 0;
+            nsapi_error_t ret = write_blocks(_block, len);
+            if (ret < 0) return ret;
+        }
+
+        return sync();
+    }
+
+    nsapi_error_t write_blocks(const char* data, uint32_t size) {
+        _block_writes++;
+        return write_storage(data, size);
+    }
+
+    char* _block;
+    uint32_t _block_size;
+    uint32_t _block_ix;
+    uint32_t _block_writes;
+};
+
+/**
+ * \brief FileBodySink writes the body to a stdio FILE, or to a POSIX file descriptor, in blocks.
+ * The file is not owned by the sink, and is not closed.
+ */
+class FileBodySink : public BlockBodySink {
+public:
+    /**
+     * FileBodySink Constructor
+     *
+     * @param[in] file An open FILE (opened with "wb" or similar)
+     * @param[in] block_size Size of the writes, ideally the block size of the file system
+     */
+    FileBodySink(FILE* file, uint32_t block_size = HTTP_BODY_SINK_BLOCK_SIZE)
+        : BlockBodySink(block_size), _file(file), _fd(-1)
+    {}
+
+    /**
+     * FileBodySink Constructor
+     *
+     * @param[in] fd An open file descriptor
+     * @param[in] block_size Size of the writes, ideally the block size of the file system
+     */
+    FileBodySink(int fd, uint32_t block_size = HTTP_BODY_SINK_BLOCK_SIZE)
+        : BlockBodySink(block_size), _file(NULL), _fd(fd)
+    {}
+
+protected:
+    virtual nsapi_error_t write_storage(const char* data, uint32_t size) {
+        if (_file) {
+            return fwrite(data, 1, size, _file) == size ? NSAPI_ERROR_OK : NSAPI_ERROR_DEVICE_ERROR;
+        }
+
+        while (size > 0) {
+            ssize_t ret = ::write(_fd, data, size);
+            if (ret <= 0) {
+                return NSAPI_ERROR_DEVICE_ERROR;
+            }
+            data += ret;
+            size -= ret;
+        }
+        return NSAPI_ERROR_OK;
+    }
+
+    virtual nsapi_error_t sync() {
+        if (_file) {
+            return fflush(_file) == 0 ? NSAPI_ERROR_OK : NSAPI_ERROR_DEVICE_ERROR;
+        }
+        return fsync(_fd) == 0 ? NSAPI_ERROR_OK : NSAPI_ERROR_DEVICE_ERROR;
+    }
+
+    // the file is not truncated, data beyond the new body stays in the file
+    virtual nsapi_error_t rewind_storage() {
+        if (_file) {
+            return fseek(_file, 0, SEEK_SET) == 0 ? NSAPI_ERROR_OK : NSAPI_ERROR_DEVICE_ERROR;
+        }
+        return lseek(_fd, 0, SEEK_SET) == 0 ? NSAPI_ERROR_OK : NSAPI_ERROR_DEVICE_ERROR;
+    }
+
+private:
+    FILE* _file;
+    int _fd;
+};
+
+/**
+ * \brief FileSystemBodySink writes the body to a file on an mbed FileSystem, in blocks.
+ * The file is created (or truncated, unless appending) by the constructor, and closed when the sink is deleted.
+ */
+class FileSystemBodySink : public BlockBodySink {
+public:
+    /**
+     * FileSystemBodySink Constructor
+     *
+     * @param[in] fs A mounted file system
+     * @param[in] path Path of the file, relative to the file system
+     * @param[in] block_size Size of the writes, ideally the block size of the file system
+     * @param[in] append Append to the file instead of truncating it, e.g. to resume a download
+     */
+    FileSystemBodySink(FileSystem* fs, const char* path, uint32_t block_size = HTTP_BODY_SINK_BLOCK_SIZE, bool append = false)
+        : BlockBodySink(block_size)
+    {
+        if (_file.open(fs, path, O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC)) != 0) {
+            _error = NSAPI_ERROR_DEVICE_ERROR;
+        }
+    }
+
+    virtual ~FileSystemBodySink() {
+        _file.close();
+    }
+
+protected:
+    virtual nsapi_error_t write_storage(const char* data, uint32_t size) {
+        return _file.write(data, size) == (ssize_t)size ? NSAPI_ERROR_OK : NSAPI_ERROR_DEVICE_ERROR;
+    }
+
+    virtual nsapi_error_t sync() {
+        return _file.sync() == 0 ? NSAPI_ERROR_OK : NSAPI_ERROR_DEVICE_ERROR;
+    }
+
+    virtual nsapi_error_t rewind_storage() {
+        if (_file.truncate(0) != 0 || _file.seek(0, SEEK_SET) != 0) {
+            return NSAPI_ERROR_DEVICE_ERROR;
+        }
+        return NSAPI_ERROR_OK;
+    }
+
+private:
+    File _file;
+};
+
+/**
+ * \brief BlockDeviceBodySink writes the body to a BlockDevice, starting at an address.
+ *
+ * Erase blocks are erased just before they're first programmed. The block size is rounded up to
+ * a multiple of the program size; the last block is padded with the erase value. Because of that
+ * padding the sink cannot continue after a flush(), so resumable downloads can't checkpoint into it.
+ */
+class BlockDeviceBodySink : public BlockBodySink {
+public:
+    /**
+     * BlockDeviceBodySink Constructor
+     *
+     * @param[in] bd An initialized block device
+     * @param[in] start Address to write the body to, needs to be aligned to an erase block
+     * @param[in] block_size Size of the writes
+     */
+    BlockDeviceBodySink(BlockDevice* bd, bd_addr_t start = 0, uint32_t block_size = HTTP_BODY_SINK_BLOCK_SIZE)
+        : BlockBodySink(round_up(block_size, bd->get_program_size())),
+          _bd(bd), _start(start), _address(start), _erased_until(start)
+    {
+        if (!bd->is_valid_erase(start, bd->get_erase_size(start))) {
+            _error = NSAPI_ERROR_PARAMETER;
+        }
+    }
+
+    /**
+     * Address right after the last byte that was written.
+     */
+    bd_addr_t get_address() {
+        return _address;
+    }
+
+    virtual nsapi_error_t flush() {
+        return NSAPI_ERROR_UNSUPPORTED;
+    }
+
+protected:
+    virtual nsapi_error_t write_storage(const char* data, uint32_t size) {
+        bd_size_t program_size = _bd->get_program_size();
+        uint32_t aligned = size - (size % program_size);
+        uint32_t padded = size == aligned ? size : aligned + program_size;
+
+        if (_address + padded > _bd->size()) {
+            return NSAPI_ERROR_NO_MEMORY;
+        }
+
+        while (_erased_until < _address + padded) {
+            bd_size_t erase_size = _bd->get_erase_size(_erased_until);
+            if (_bd->erase(_erased_until, erase_size) != BD_ERROR_OK) {
+                return NSAPI_ERROR_DEVICE_ERROR;
+            }
+            _erased_until += erase_size;
+        }
+
+        if (aligned > 0) {
+            if (_bd->program(data, _address, aligned) != BD_ERROR_OK) {
+                return NSAPI_ERROR_DEVICE_ERROR;
+            }
+            _address += aligned;
+        }
+
+        // only the last write is not aligned, pad it to a full program unit
+        if (aligned < size) {
+            char* tail = (char*)malloc(program_size);
+            if (!tail) {
+                return NSAPI_ERROR_NO_MEMORY;
+            }
+
+            int erase_value = _bd->get_erase_value();
+            memset(tail, erase_value < 0 ? 0xFF : erase_value, program_size);
+            memcpy(tail, data + aligned, size - aligned);
+
+            int ret = _bd->program(tail, _address, program_size);
+            free(tail);
+            if (ret != BD_ERROR_OK) {
+                return NSAPI_ERROR_DEVICE_ERROR;
+            }
+            _address += size - aligned;
+        }
+
+        return NSAPI_ERROR_OK;
+    }
+
+    virtual nsapi_error_t sync() {
+        return _bd->sync() == BD_ERROR_OK ? NSAPI_ERROR_OK : NSAPI_ERROR_DEVICE_ERROR;
+    }
+
+    // blocks are erased again when they're written
+    virtual nsapi_error_t rewind_storage() {
+        _address = _start;
+        _erased_until = _start;
+        return NSAPI_ERROR_OK;
+    }
+
+private:
+    static uint32_t round_up(uint32_t size, bd_size_t multiple) {
+        if (multiple <= 1) return size;
+        return ((size + multiple - 1) / multiple) * multiple;
+    }
+
+    BlockDevice* _bd;
+    bd_addr_t _start;
+    bd_addr_t _address;
+    bd_addr_t _erased_until;
+};
+
+/**
+ * \brief RandomAccessSink stores data at any offset. SegmentedDownload writes the segments of a resource into it,
+ * in whatever order they arrive.
+ */
+class RandomAccessSink {
+public:
+    virtual ~RandomAccessSink() {}
+
+    /**
+     * Called before the first write, with the size of the resource (0 if not known).
+     */
+    virtual nsapi_error_t set_size(uint32_t /*size*/) {
+        return NSAPI_ERROR_OK;
+    }
+
+    /**
+     * Store data at an offset. Called from the event queue that runs the download.
+     */
+    virtual nsapi_error_t write_at(uint32_t offset, const char* data, uint32_t size) = 0;
+
+    /**
+     * Called once all data was written.
+     */
+    virtual nsapi_error_t finish() {
+        return NSAPI_ERROR_OK;
+    }
+};
+
+/**
+ * \brief MemoryRandomAccessSink keeps the resource in a heap buffer, allocated at once if the size is known.
+ */
+class MemoryRandomAccessSink : public RandomAccessSink {
+public:
+    /**
+     * MemoryRandomAccessSink Constructor
+     *
+     * @param[in] max_size Maximum size, larger resources fail with NSAPI_ERROR_NO_MEMORY (0 for no limit)
+     */
+    MemoryRandomAccessSink(uint32_t max_size = 0)
+        : _data(NULL), _size(0), _capacity(0), _max_size(max_size)
+    {}
+
+    virtual ~MemoryRandomAccessSink() {
+        free(_data);
+    }
+
+    virtual nsapi_error_t set_size(uint32_t size) {
+        _size = 0;
+        return size == 0 ? NSAPI_ERROR_OK : reserve(size);
+    }
+
+    virtual nsapi_error_t write_at(uint32_t offset, const char* data, uint32_t size) {
+        if (offset + size > _capacity) {
+            nsapi_error_t ret = reserve(offset + size);
+            if (ret != NSAPI_ERROR_OK) {
+                return ret;
+            }
+        }
+
+        memcpy(_data + offset, data, size);
+        if (offset + size > _size) {
+            _size = offset + size;
+        }
+        return NSAPI_ERROR_OK;
+    }
+
+    const char* get_data() {
+        return _data;
+    }
+
+    /**
+     * End of the data that was written furthest into the buffer.
+     */
+    uint32_t get_size() {
+        return _size;
+    }
+
+private:
+    nsapi_error_t reserve(uint32_t size) {
+        if (_max_size != 0 && size > _max_size) {
+            return NSAPI_ERROR_NO_MEMORY;
+        }
+
+        uint32_t capacity = _capacity == 0 ? HTTP_RESPONSE_BODY_INITIAL_SIZE : _capacity;
+        while (capacity < size) {
+            capacity *= 2;
+        }
+        if (_max_size != 0 && capacity > _max_size) {
+            capacity = _max_size;
+        }
+
+        char* new_data = (char*)realloc(_data, capacity);
+        if (!new_data) {
+            return NSAPI_ERROR_NO_MEMORY;
+        }
+        _data = new_data;
+        _capacity = capacity;
+        return NSAPI_ERROR_OK;
+    }
+
+    char* _data;
+    uint32_t _size;
+    uint32_t _capacity;
+    uint32_t _max_size;
+};
+
+/**
+ * \brief FileRandomAccessSink writes the resource to a stdio FILE, or to a POSIX file descriptor, seeking to
+ * every offset. The file is not owned by the sink, and is not closed.
+ */
+class FileRandomAccessSink : public RandomAccessSink {
+public:
+    /**
+     * FileRandomAccessSink Constructor
+     *
+     * @param[in] file An open FILE (opened with "wb+" or similar)
+     */
+    FileRandomAccessSink(FILE* file)
+        : _file(file), _fd(-1)
+    {}
+
+    /**
+     * FileRandomAccessSink Constructor
+     *
+     * @param[in] fd An open file descriptor
+     */
+    FileRandomAccessSink(int fd)
+        : _file(NULL), _fd(fd)
+    {}
+
+    virtual nsapi_error_t write_at(uint32_t offset, const char* data, uint32_t size) {
+        if (_file) {
+            if (fseek(_file, offset, SEEK_SET) != 0) {
+                return NSAPI_ERROR_DEVICE_ERROR;
+            }
+            return fwrite(data, 1, size, _file) == size ? NSAPI_ERROR_OK : NSAPI_ERROR_DEVICE_ERROR;
+        }
+
+        if (lseek(_fd, offset, SEEK_SET) != (off_t)offset) {
+            return NSAPI_ERROR_DEVICE_ERROR;
+        }
+        while (size > 0) {
+            ssize_t ret = ::write(_fd, data, size);
+            if (ret <= 0) {
+                return NSAPI_ERROR_DEVICE_ERROR;
+            }
+            data += ret;
+            size -= ret;
+        }
+        return NSAPI_ERROR_OK;
+    }
+
+    virtual nsapi_error_t finish() {
+        if (_file) {
+            return fflush(_file) == 0 ? NSAPI_ERROR_OK : NSAPI_ERROR_DEVICE_ERROR;
+        }
+        return fsync(_fd) == 0 ? NSAPI_ERROR_OK : NSAPI_ERROR_DEVICE_ERROR;
+    }
+
+private:
+    FILE* _file;
+    int _fd;
+};
+
+#endif // _MBED_HTTP_BODY_SINK_H_
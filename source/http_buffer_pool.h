@@ -0,0 +1,239 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MBED_HTTP_BUFFER_POOL_H_
+#define _MBED_HTTP_BUFFER_POOL_H_
+
+#include <vector>
+#include "mbed.h"
+
+#ifndef HTTP_BUFFER_POOL_SMALL_SIZE
+#define HTTP_BUFFER_POOL_SMALL_SIZE 1024
+#endif
+
+#ifndef HTTP_BUFFER_POOL_SMALL_COUNT
+#define HTTP_BUFFER_POOL_SMALL_COUNT 2
+#endif
+
+#ifndef HTTP_BUFFER_POOL_LARGE_SIZE
+#define HTTP_BUFFER_POOL_LARGE_SIZE 8 * 1024
+#endif
+
+#ifndef HTTP_BUFFER_POOL_LARGE_COUNT
+#define HTTP_BUFFER_POOL_LARGE_COUNT 2
+#endif
+
+using namespace std;
+
+/**
+ * A size class of a BufferPool: count buffers of size bytes.
+ */
+struct BufferPoolClass {
+    uint32_t size;
+    uint32_t count;
+};
+
+/**
+ * \brief BufferPool hands out receive buffers that are allocated once, instead of on every request.
+ *
+ * The buffers of every size class are allocated in one block when the pool is constructed, so using
+ * the pool does not churn or fragment the heap. A single pool can be shared between threads and requests.
+ */
+class BufferPool {
+public:
+    /**
+     * BufferPool Constructor, with the two size classes from mbed_lib.json
+     * (HTTP_BUFFER_POOL_SMALL_SIZE/COUNT and HTTP_BUFFER_POOL_LARGE_SIZE/COUNT).
+     */
+    BufferPool()
+        : _in_use(0), _high_water(0), _misses(0)
+    {
+        add_class(HTTP_BUFFER_POOL_SMALL_SIZE, HTTP_BUFFER_POOL_SMALL_COUNT);
+        add_class(HTTP_BUFFER_POOL_LARGE_SIZE, HTTP_BUFFER_POOL_LARGE_COUNT);
+    }
+
+    /**
+     * BufferPool Constructor
+     *
+     * @param[in] classes Size classes, in ascending order of size
+     * @param[in] class_count Number of size classes
+     */
+    BufferPool(const BufferPoolClass* classes, size_t class_count)
+        : _in_use(0), _high_water(0), _misses(0)
+    {
+        for (size_t ix = 0; ix < class_count; ix++) {
+            add_class(classes[ix].size, classes[ix].count);
+        }
+    }
+
+    ~BufferPool() {
+        for (size_t ix = 0; ix < _classes.size(); ix++) {
+            free(_classes[ix].memory);
+            free(_classes[ix].used);
+        }
+    }
+
+    /**
+     * Borrow a buffer. Prefers the smallest free buffer of at least size bytes;
+     * if all of those are in use, the largest free smaller buffer is returned.
+     *
+     * @param[in] size Preferred size of the buffer
+     * @param[out] actual_size Size of the returned buffer
+     * @return A buffer, or NULL if all buffers are in use
+     */
+    void* acquire(uint32_t size, uint32_t* actual_size) {
+        _mutex.lock();
+
+        void* buffer = NULL;
+
+        for (size_t ix = 0; ix < _classes.size() && !buffer; ix++) {
+            if (_classes[ix].size >= size) {
+                buffer = take(_classes[ix], actual_size);
+            }
+        }
+        for (size_t ix = _classes.size(); ix > 0 && !buffer; ix--) {
+            if (_classes[ix - 1].size < size) {
+                buffer = take(_classes[ix - 1], actual_size);
+            }
+        }
+
+        if (!buffer) {
+            _misses++;
+        }
+
+        _mutex.unlock();
+        return buffer;
+    }
+
+    /**
+     * Return a buffer to the pool.
+     *
+     * @return true if the buffer belongs to the pool, false if not (nothing happens)
+     */
+    bool release(void* buffer) {
+        _mutex.lock();
+
+        for (size_t ix = 0; ix < _classes.size(); ix++) {
+            Class& c = _classes[ix];
+            char* p = (char*)buffer;
+
+            if (c.memory && p >= c.memory && p < c.memory + (c.size * c.count)) {
+                c.used[(p - c.memory) / c.size] = 0;
+                _in_use -= c.size;
+
+                _mutex.unlock();
+                return true;
+            }
+        }
+
+        _mutex.unlock();
+        return false;
+    }
+
+    /**
+     * Number of bytes currently borrowed.
+     */
+    uint32_t get_in_use() {
+        _mutex.lock();
+        uint32_t in_use = _in_use;
+        _mutex.unlock();
+        return in_use;
+    }
+
+    /**
+     * Maximum number of bytes that were borrowed at the same time.
+     */
+    uint32_t get_high_water() {
+        _mutex.lock();
+        uint32_t high_water = _high_water;
+        _mutex.unlock();
+        return high_water;
+    }
+
+    /**
+     * Number of times acquire() found no free buffer.
+     */
+    uint32_t get_misses() {
+        _mutex.lock();
+        uint32_t misses = _misses;
+        _mutex.unlock();
+        return misses;
+    }
+
+    /**
+     * Total number of bytes allocated for the buffers.
+     */
+    uint32_t get_capacity() {
+        uint32_t capacity = 0;
+        for (size_t ix = 0; ix < _classes.size(); ix++) {
+            capacity += _classes[ix].size * _classes[ix].count;
+        }
+        return capacity;
+    }
+
+private:
+    struct Class {
+        uint32_t size;
+        uint32_t count;
+        char* memory;
+        uint8_t* used;
+    };
+
+    void add_class(uint32_t size, uint32_t count) {
+        if (size == 0 || count == 0) {
+            return;
+        }
+
+        Class c;
+        c.size = size;
+        c.count = count;
+        c.memory = (char*)malloc(size * count);
+        c.used = (uint8_t*)calloc(count, 1);
+
+        if (!c.memory || !c.used) {
+            free(c.memory);
+            free(c.used);
+            return;
+        }
+
+        _classes.push_back(c);
+    }
+
+    void* take(Class& c, uint32_t* actual_size) {
+        for (uint32_t ix = 0; ix < c.count; ix++) {
+            if (c.used[ix]) continue;
+
+            c.used[ix] = 1;
+            _in_use += c.size;
+            if (_in_use > _high_water) {
+                _high_water = _in_use;
+            }
+
+            *actual_size = c.size;
+            return c.memory + (ix * c.size);
+        }
+        return NULL;
+    }
+
+    vector<Class> _classes;
+    uint32_t _in_use;
+    uint32_t _high_water;
+    uint32_t _misses;
+    PlatformMutex _mutex;
+};
+
+#endif // _MBED_HTTP_BUFFER_POOL_H_
@@ -0,0 +1,153 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MBED_HTTP_CHUNKED_WRITER_H_
+#define _MBED_HTTP_CHUNKED_WRITER_H_
+
+#include "mbed.h"
+
+#ifndef HTTP_CHUNKED_BUFFER_SIZE
+#define HTTP_CHUNKED_BUFFER_SIZE 1024
+#endif
+
+/**
+ * Statistics of a chunked-encoding upload.
+ */
+struct ChunkedWriterStats {
+    uint32_t chunks;        // number of body chunks
+    uint32_t payload_bytes; // body bytes
+    uint32_t wire_bytes;    // bytes written to the socket, including headers and chunk framing
+    uint32_t writes;        // number of writes handed to the socket
+};
+
+/**
+ * \brief ChunkedWriter frames data in chunked transfer-encoding, and coalesces the frames in a staging buffer.
+ *
+ * The chunk size line, payload and trailing CRLF of a chunk are written to the socket in one go
+ * (so with TLS they end up in one record), and small chunks are combined until the staging buffer is full.
+ * Payloads that don't fit in the staging buffer are written directly after it, without copying.
+ */
+class ChunkedWriter {
+public:
+    /**
+     * ChunkedWriter Constructor
+     *
+     * @param[in] write Function that writes a buffer completely to the socket, returns a negative value on error
+     * @param[in] buffer Staging buffer
+     * @param[in] buffer_size Size of the staging buffer, needs to be at least 16 bytes
+     */
+    ChunkedWriter(Callback<nsapi_size_or_error_t(char*, uint32_t)> write, char* buffer, uint32_t buffer_size)
+        : _write(write), _buffer(buffer), _buffer_size(buffer_size), _buffer_ix(0)
+    {
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    /**
+     * Write data as-is (e.g. the request headers), through the staging buffer.
+     */
+    nsapi_size_or_error_t write_raw(const char* data, uint32_t size) {
+        while (size > 0) {
+            if (_buffer_ix == _buffer_size) {
+                nsapi_size_or_error_t ret = flush();
+                if (ret < 0) return ret;
+            }
+
+            // large writes go straight out, no need to copy them
+            if (_buffer_ix == 0 && size >= _buffer_size) {
+                return write_direct(data, size);
+            }
+
+            uint32_t len = size < _buffer_size - _buffer_ix ? size : _buffer_size - _buffer_ix;
+            memcpy(_buffer + _buffer_ix, data, len);
+            _buffer_ix += len;
+            data += len;
+            size -= len;
+        }
+        return NSAPI_ERROR_OK;
+    }
+
+    /**
+     * Write one chunk: size in HEX, CRLF, data, CRLF.
+     */
+    nsapi_size_or_error_t write_chunk(const void* data, uint32_t size) {
+        if (size == 0) {
+            return NSAPI_ERROR_OK;
+        }
+
+        char size_buff[12]; // if sending length of more than 8 digits, you have another problem on a microcontroller...
+        int size_buff_size = snprintf(size_buff, sizeof(size_buff), "%X\r\n", static_cast<unsigned int>(size));
+
+        nsapi_size_or_error_t ret;
+        if ((ret = write_raw(size_buff, size_buff_size)) < 0) return ret;
+        if ((ret = write_raw((const char*)data, size)) < 0) return ret;
+        if ((ret = write_raw("\r\n", 2)) < 0) return ret;
+
+        _stats.chunks++;
+        _stats.payload_bytes += size;
+        return NSAPI_ERROR_OK;
+    }
+
+    /**
+     * Write the terminating zero-size chunk, and flush everything to the socket.
+     */
+    nsapi_size_or_error_t finish() {
+        nsapi_size_or_error_t ret = write_raw("0\r\n\r\n", 5);
+        if (ret < 0) return ret;
+
+        return flush();
+    }
+
+    /**
+     * Write the staging buffer to the socket.
+     */
+    nsapi_size_or_error_t flush() {
+        if (_buffer_ix == 0) {
+            return NSAPI_ERROR_OK;
+        }
+
+        nsapi_size_or_error_t ret = write_direct(_buffer, _buffer_ix);
+        _buffer_ix = 0;
+        return ret;
+    }
+
+    ChunkedWriterStats get_stats() {
+        return _stats;
+    }
+
+private:
+    nsapi_size_or_error_t write_direct(const char* data, uint32_t size) {
+        // the staging buffer has to go out first, to keep the order
+        if (data != _buffer && _buffer_ix > 0) {
+            nsapi_size_or_error_t ret = flush();
+            if (ret < 0) return ret;
+        }
+
+        _stats.writes++;
+        _stats.wire_bytes += size;
+
+        nsapi_size_or_error_t ret = _write((char*)data, size);
+        return ret < 0 ? ret : NSAPI_ERROR_OK;
+    }
+
+    Callback<nsapi_size_or_error_t(char*, uint32_t)> _write;
+    char* _buffer;
+    uint32_t _buffer_size;
+    uint32_t _buffer_ix;
+    ChunkedWriterStats _stats;
+};
+
+#endif // _MBED_HTTP_CHUNKED_WRITER_H_
@@ -0,0 +1,191 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MBED_HTTP_CONNECTION_POOL_H_
+#define _MBED_HTTP_CONNECTION_POOL_H_
+
+#include <string>
+#include <vector>
+#include "mbed.h"
+#include "netsocket/Socket.h"
+
+#ifndef HTTP_CONNECTION_POOL_MAX_IDLE
+#define HTTP_CONNECTION_POOL_MAX_IDLE 4
+#endif
+
+#ifndef HTTP_CONNECTION_POOL_IDLE_TIMEOUT
+#define HTTP_CONNECTION_POOL_IDLE_TIMEOUT 30000
+#endif
+
+using namespace std;
+
+/**
+ * \brief ConnectionPool keeps idle keep-alive sockets around so they can be re-used by later requests.
+ *
+ * Sockets are keyed by schema, host and port, so a pooled TLSSocket is only handed out to HttpsRequest
+ * objects for the same host. The pool owns every idle socket and deletes it when it's evicted.
+ * A single pool can be shared between threads and between HttpRequest and HttpsRequest objects.
+ */
+class ConnectionPool {
+public:
+    /**
+     * ConnectionPool Constructor
+     *
+     * @param[in] max_idle Maximum number of idle sockets kept (over all hosts)
+     * @param[in] idle_timeout_ms Idle sockets older than this are closed instead of re-used
+     */
+    ConnectionPool(uint32_t max_idle = HTTP_CONNECTION_POOL_MAX_IDLE,
+                   uint32_t idle_timeout_ms = HTTP_CONNECTION_POOL_IDLE_TIMEOUT)
+        : _max_idle(max_idle), _idle_timeout_ms(idle_timeout_ms)
+    {}
+
+    ~ConnectionPool() {
+        clear();
+    }
+
+    /**
+     * Take an idle socket for the given endpoint out of the pool.
+     * Sockets that the server has closed in the meantime are discarded.
+     *
+     * @return A connected socket (now owned by the caller), or NULL if none is available
+     */
+    Socket* acquire(const char* schema, const char* host, uint16_t port) {
+        string key = make_key(schema, host, port);
+
+        _mutex.lock();
+        evict_expired();
+
+        Socket* socket = NULL;
+
+        // take the most recently used one, it's the least likely to have been closed by the server
+        for (size_t ix = _entries.size(); ix > 0; ix--) {
+            if (_entries[ix - 1].key != key) continue;
+
+            Socket* candidate = _entries[ix - 1].socket;
+            _entries.erase(_entries.begin() + (ix - 1));
+
+            if (is_stale(candidate)) {
+                delete candidate;
+                continue;
+            }
+
+            socket = candidate;
+            break;
+        }
+        _mutex.unlock();
+
+        return socket;
+    }
+
+    /**
+     * Hand a connected socket back to the pool after a complete keep-alive response.
+     * The pool takes ownership of the socket.
+     */
+    void release(const char* schema, const char* host, uint16_t port, Socket* socket) {
+        Entry entry;
+        entry.key = make_key(schema, host, port);
+        entry.socket = socket;
+        entry.idle_since = Kernel::get_ms_count();
+
+        _mutex.lock();
+        evict_expired();
+
+        _entries.push_back(entry);
+
+        // entries are in release order, so the front one has been idle the longest
+        while (_entries.size() > _max_idle) {
+            delete _entries.front().socket;
+            _entries.erase(_entries.begin());
+        }
+        _mutex.unlock();
+    }
+
+    /**
+     * Close and delete all idle sockets.
+     */
+    void clear() {
+        _mutex.lock();
+        for (size_t ix = 0; ix < _entries.size(); ix++) {
+            delete _entries[ix].socket;
+        }
+        _entries.clear();
+        _mutex.unlock();
+    }
+
+    /**
+     * Number of idle sockets currently in the pool.
+     */
+    uint32_t get_idle_count() {
+        _mutex.lock();
+        uint32_t count = _entries.size();
+        _mutex.unlock();
+        return count;
+    }
+
+private:
+    struct Entry {
+        string key;
+        Socket* socket;
+        uint64_t idle_since;
+    };
+
+    static string make_key(const char* schema, const char* host, uint16_t port) {
+        char port_str[8];
+        snprintf(port_str, sizeof(port_str), "%u", port);
+
+        string key(schema);
+        key += "://";
+        key += host;
+        key += ":";
+        key += port_str;
+        return key;
+    }
+
+    void evict_expired() {
+        uint64_t now = Kernel::get_ms_count();
+
+        for (size_t ix = 0; ix < _entries.size(); ) {
+            if (now - _entries[ix].idle_since >= _idle_timeout_ms) {
+                delete _entries[ix].socket;
+                _entries.erase(_entries.begin() + ix);
+            }
+            else {
+                ix++;
+            }
+        }
+    }
+
+    // An idle keep-alive socket should have nothing to read. If recv returns data or 0 (peer closed)
+    // or an error, the connection can't be used for a new request anymore.
+    static bool is_stale(Socket* socket) {
+        uint8_t probe;
+
+        socket->set_blocking(false);
+        nsapi_size_or_error_t ret = socket->recv(&probe, 1);
+        socket->set_blocking(true);
+
+        return ret != NSAPI_ERROR_WOULD_BLOCK;
+    }
+
+    uint32_t _max_idle;
+    uint32_t _idle_timeout_ms;
+
+    vector<Entry> _entries;
+    PlatformMutex _mutex;
+};
+
+#endif // _MBED_HTTP_CONNECTION_POOL_H_
@@ -0,0 +1,653 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MBED_HTTP_DEFLATER_H_
+#define _MBED_HTTP_DEFLATER_H_
+
+#include "mbed.h"
+#include "http_inflater.h"
+
+#ifndef HTTP_DEFLATE_WINDOW_SIZE
+#define HTTP_DEFLATE_WINDOW_SIZE 4096
+#endif
+
+#ifndef HTTP_DEFLATE_HASH_BITS
+#define HTTP_DEFLATE_HASH_BITS 10
+#endif
+
+#ifndef HTTP_DEFLATE_BLOCK_SYMBOLS
+#define HTTP_DEFLATE_BLOCK_SYMBOLS 2048
+#endif
+
+#ifndef HTTP_DEFLATE_OUTPUT_SIZE
+#define HTTP_DEFLATE_OUTPUT_SIZE 512
+#endif
+
+/**
+ * \brief HttpDeflater compresses a stream into gzip or deflate (zlib) format, as it comes in.
+ *
+ * Matches are found through a hash table of the last position of every 3-byte sequence (no hash chains).
+ * Literals and matches are collected per block, and every block is written with its own Huffman code,
+ * or with the fixed Huffman code when that is smaller. Memory use is fixed when constructed:
+ * two windows for history and lookahead, two bytes per hash table entry, three bytes per block symbol,
+ * the output buffer and about 4K for the Huffman tables (part of the object, so allocate it on the heap).
+ * Compressed data is handed to the output callback whenever the output buffer is full, and by finish().
+ */
+class HttpDeflater {
+public:
+    enum deflate_format {
+        DEFLATE_GZIP,       // gzip (RFC 1952)
+        DEFLATE_ZLIB        // zlib (RFC 1950), what HTTP calls 'deflate'
+    };
+
+    /**
+     * HttpDeflater Constructor
+     *
+     * @param[in] format Format of the stream
+     * @param[in] output Callback that receives the compressed data, returns a negative value on error
+     * @param[in] window_size How far back matches are searched, between 1K and 16K
+     * @param[in] hash_bits Size of the hash table, 1 << hash_bits entries, between 8 and 15
+     * @param[in] block_symbols Number of literals and matches per block, between 256 and 32K
+     * @param[in] output_size Size of the output buffer
+     */
+    HttpDeflater(deflate_format format, Callback<nsapi_size_or_error_t(const void*, uint32_t)> output,
+                 uint32_t window_size = HTTP_DEFLATE_WINDOW_SIZE, uint32_t hash_bits = HTTP_DEFLATE_HASH_BITS,
+                 uint32_t block_symbols = HTTP_DEFLATE_BLOCK_SYMBOLS, uint32_t output_size = HTTP_DEFLATE_OUTPUT_SIZE)
+        : _format(format), _output(output),
+          _window_size(window_size < 1024 ? 1024 : (window_size > 16384 ? 16384 : window_size)),
+          _hash_bits(hash_bits < 8 ? 8 : (hash_bits > 15 ? 15 : hash_bits)), _pos(0), _end(0),
+          _block_symbols(block_symbols < 256 ? 256 : (block_symbols > 32768 ? 32768 : block_symbols)), _symbols(0),
+          _out_size(output_size < 16 ? 16 : output_size), _out_ix(0), _bitbuf(0), _bitcnt(0),
+          _total_in(0), _total_out(0), _crc(0xFFFFFFFF), _adler_a(1), _adler_b(0), _started(false),
+          _error(NSAPI_ERROR_OK)
+    {
+        _buffer = (uint8_t*)malloc(_window_size * 2);
+        _head = (uint16_t*)malloc(sizeof(uint16_t) << _hash_bits);
+        _sym_value = (uint8_t*)malloc(_block_symbols);
+        _sym_dist = (uint16_t*)malloc(sizeof(uint16_t) * _block_symbols);
+        _out = (uint8_t*)malloc(_out_size);
+
+        if (!_buffer || !_head || !_sym_value || !_sym_dist || !_out) {
+            _error = NSAPI_ERROR_NO_MEMORY;
+            return;
+        }
+
+        memset(_head, 0xFF, sizeof(uint16_t) << _hash_bits);
+        memset(_lit_freq, 0, sizeof(_lit_freq));
+        memset(_dist_freq, 0, sizeof(_dist_freq));
+    }
+
+    ~HttpDeflater() {
+        free(_buffer);
+        free(_head);
+        free(_sym_value);
+        free(_sym_dist);
+        free(_out);
+    }
+
+    /**
+     * Compress the next part of the stream.
+     *
+     * @return NSAPI_ERROR_OK, or an error (from the output callback, or NSAPI_ERROR_NO_MEMORY)
+     */
+    nsapi_error_t write(const void* data, uint32_t size) {
+        if (_error != NSAPI_ERROR_OK) {
+            return _error;
+        }
+
+        start();
+
+        const uint8_t* p = (const uint8_t*)data;
+        while (size > 0 && _error == NSAPI_ERROR_OK) {
+            if (_end == _window_size * 2) {
+                slide();
+            }
+
+            uint32_t len = _window_size * 2 - _end < size ? _window_size * 2 - _end : size;
+            memcpy(_buffer + _end, p, len);
+            update_checksum(p, len);
+            _end += len;
+            _total_in += len;
+            p += len;
+            size -= len;
+
+            // keep enough lookahead for the longest match
+            compress(false);
+        }
+
+        return _error;
+    }
+
+    /**
+     * Compress the remaining input, end the stream and hand everything to the output callback.
+     * Call once, after the last write().
+     *
+     * @return NSAPI_ERROR_OK, or an error
+     */
+    nsapi_error_t finish() {
+        if (_error != NSAPI_ERROR_OK) {
+            return _error;
+        }
+
+        start();
+        compress(true);
+        write_block(true);
+
+        // byte-align
+        if (_bitcnt > 0) {
+            put_bits(0, 8 - _bitcnt);
+        }
+
+        if (_format == DEFLATE_GZIP) {
+            uint32_t crc = _crc ^ 0xFFFFFFFF;
+            for (int ix = 0; ix < 4; ix++) put_byte((crc >> (ix * 8)) & 0xFF);
+            for (int ix = 0; ix < 4; ix++) put_byte((_total_in >> (ix * 8)) & 0xFF);
+        }
+        else {
+            uint32_t adler = (_adler_b << 16) | _adler_a;
+            for (int ix = 3; ix >= 0; ix--) put_byte((adler >> (ix * 8)) & 0xFF);
+        }
+
+        flush();
+        return _error;
+    }
+
+    /**
+     * Number of bytes written into the deflater.
+     */
+    uint32_t get_uncompressed_bytes() {
+        return _total_in;
+    }
+
+    /**
+     * Number of compressed bytes handed to the output callback.
+     */
+    uint32_t get_compressed_bytes() {
+        return _total_out;
+    }
+
+private:
+    enum {
+        MIN_MATCH = 3,
+        MAX_MATCH = 258,
+        NIL = 0xFFFF,
+        LIT_CODES = 286,
+        FIXED_LIT_CODES = 288,
+        DIST_CODES = 30,
+        CL_CODES = 19
+    };
+
+    // Writes the stream header
+    void start() {
+        if (_started) {
+            return;
+        }
+        _started = true;
+
+        if (_format == DEFLATE_GZIP) {
+            // ID1 ID2 CM FLG MTIME(4) XFL OS(unknown)
+            static const uint8_t header[10] = { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF };
+            for (int ix = 0; ix < 10; ix++) put_byte(header[ix]);
+        }
+        else {
+            // CMF: deflate, window size; FLG: check bits
+            uint32_t cinfo = 0;
+            while ((256UL << (cinfo + 1)) <= _window_size) cinfo++;
+            uint32_t cmf = (cinfo << 4) | 8;
+            uint32_t flg = 31 - ((cmf << 8) % 31);
+            put_byte(cmf);
+            put_byte(flg);
+        }
+    }
+
+    void compress(bool flush_all) {
+        while (_pos < _end && (flush_all || _end - _pos > MAX_MATCH) && _error == NSAPI_ERROR_OK) {
+            uint32_t available = _end - _pos;
+            uint32_t match_len = 0;
+            uint32_t match_dist = 0;
+
+            if (available >= MIN_MATCH) {
+                uint32_t h = hash(_pos);
+                uint32_t candidate = _head[h];
+                _head[h] = _pos;
+
+                if (candidate != NIL && candidate < _pos && _pos - candidate <= _window_size) {
+                    uint32_t max = available < (uint32_t)MAX_MATCH ? available : (uint32_t)MAX_MATCH;
+                    const uint8_t* a = _buffer + candidate;
+                    const uint8_t* b = _buffer + _pos;
+                    uint32_t len = 0;
+                    while (len < max && a[len] == b[len]) {
+                        len++;
+                    }
+                    if (len >= MIN_MATCH) {
+                        match_len = len;
+                        match_dist = _pos - candidate;
+                    }
+                }
+            }
+
+            if (match_len == 0) {
+                add_symbol(_buffer[_pos], 0);
+                _pos++;
+                continue;
+            }
+
+            add_symbol(match_len - MIN_MATCH, match_dist);
+
+            // index the positions inside the match too, so later data can refer to them
+            uint32_t end = _pos + match_len;
+            for (_pos++; _pos < end; _pos++) {
+                if (_end - _pos >= MIN_MATCH) {
+                    _head[hash(_pos)] = _pos;
+                }
+            }
+        }
+    }
+
+    // Drops the older window, keeps the last window_size bytes of history
+    void slide() {
+        memmove(_buffer, _buffer + _window_size, _window_size);
+        _pos -= _window_size;
+        _end -= _window_size;
+
+        for (uint32_t ix = 0; ix < (1UL << _hash_bits); ix++) {
+            _head[ix] = (_head[ix] != NIL && _head[ix] >= _window_size) ? _head[ix] - _window_size : (uint16_t)NIL;
+        }
+    }
+
+    uint32_t hash(uint32_t pos) {
+        uint32_t v = (_buffer[pos] << 16) | (_buffer[pos + 1] << 8) | _buffer[pos + 2];
+        return (uint32_t)(v * 2654435761UL) >> (32 - _hash_bits);
+    }
+
+    void update_checksum(const uint8_t* data, uint32_t size) {
+        for (uint32_t ix = 0; ix < size; ix++) {
+            if (_format == DEFLATE_GZIP) {
+                _crc = HttpInflater::crc32_update(_crc, data[ix]);
+            }
+            else {
+                HttpInflater::adler32_update(&_adler_a, &_adler_b, data[ix]);
+            }
+        }
+    }
+
+    // Records a literal (dist 0, value is the byte) or a match (value is the length - 3)
+    void add_symbol(uint8_t value, uint16_t dist) {
+        _sym_value[_symbols] = value;
+        _sym_dist[_symbols] = dist;
+        _symbols++;
+
+        if (dist == 0) {
+            _lit_freq[value]++;
+        }
+        else {
+            _lit_freq[257 + length_symbol(value + MIN_MATCH)]++;
+            _dist_freq[dist_symbol(dist)]++;
+        }
+
+        if (_symbols == _block_symbols) {
+            write_block(false);
+        }
+    }
+
+    // Writes the recorded symbols as one block, with their own Huffman code or the fixed one
+    void write_block(bool final) {
+        _lit_freq[256]++;   // end of block
+
+        memset(_lit_len, 0, FIXED_LIT_CODES);
+        build_lengths(_lit_freq, LIT_CODES, _lit_len, 15);
+        build_lengths(_dist_freq, DIST_CODES, _dist_len, 15);
+
+        uint32_t nlit = LIT_CODES;
+        while (nlit > 257 && _lit_len[nlit - 1] == 0) nlit--;
+        uint32_t ndist = DIST_CODES;
+        while (ndist > 1 && _dist_len[ndist - 1] == 0) ndist--;
+
+        uint8_t lengths[LIT_CODES + DIST_CODES];
+        memcpy(lengths, _lit_len, nlit);
+        memcpy(lengths + nlit, _dist_len, ndist);
+
+        // the code lengths are sent run-length encoded, with a Huffman code of their own
+        uint16_t cl_freq[CL_CODES];
+        uint8_t cl_len[CL_CODES];
+        memset(cl_freq, 0, sizeof(cl_freq));
+        encode_lengths(lengths, nlit + ndist, cl_freq, NULL, NULL);
+        build_lengths(cl_freq, CL_CODES, cl_len, 7);
+
+        static const uint8_t cl_order[CL_CODES] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+        uint32_t ncl = CL_CODES;
+        while (ncl > 4 && cl_len[cl_order[ncl - 1]] == 0) ncl--;
+
+        uint32_t dynamic_bits = 5 + 5 + 4 + 3 * ncl + data_bits(false);
+        for (uint32_t ix = 0; ix < CL_CODES; ix++) {
+            dynamic_bits += cl_freq[ix] * (cl_len[ix] + (ix == 16 ? 2 : (ix == 17 ? 3 : (ix == 18 ? 7 : 0))));
+        }
+
+        put_bits(final ? 1 : 0, 1);
+
+        if (dynamic_bits < data_bits(true)) {
+            put_bits(2, 2);
+            put_bits(nlit - 257, 5);
+            put_bits(ndist - 1, 5);
+            put_bits(ncl - 4, 4);
+            for (uint32_t ix = 0; ix < ncl; ix++) {
+                put_bits(cl_len[cl_order[ix]], 3);
+            }
+
+            uint16_t cl_code[CL_CODES];
+            build_codes(cl_len, CL_CODES, cl_code);
+            encode_lengths(lengths, nlit + ndist, NULL, cl_code, cl_len);
+        }
+        else {
+            put_bits(1, 2);
+            // the fixed code has two more (unused) symbols, they count for the canonical codes
+            for (uint32_t ix = 0; ix < FIXED_LIT_CODES; ix++) _lit_len[ix] = fixed_lit_length(ix);
+            memset(_dist_len, 5, DIST_CODES);
+        }
+
+        build_codes(_lit_len, FIXED_LIT_CODES, _lit_code);
+        build_codes(_dist_len, DIST_CODES, _dist_code);
+        write_symbols();
+
+        _symbols = 0;
+        memset(_lit_freq, 0, sizeof(_lit_freq));
+        memset(_dist_freq, 0, sizeof(_dist_freq));
+    }
+
+    // Size in bits of the recorded symbols, with the built code lengths or the fixed ones
+    uint32_t data_bits(bool fixed) {
+        uint32_t bits = 0;
+        for (uint32_t ix = 0; ix < LIT_CODES; ix++) {
+            uint32_t len = fixed ? fixed_lit_length(ix) : _lit_len[ix];
+            bits += _lit_freq[ix] * (len + (ix >= 257 ? length_extra(ix - 257) : 0));
+        }
+        for (uint32_t ix = 0; ix < DIST_CODES; ix++) {
+            uint32_t len = fixed ? 5 : _dist_len[ix];
+            bits += _dist_freq[ix] * (len + dist_extra(ix));
+        }
+        return bits;
+    }
+
+    void write_symbols() {
+        for (uint32_t ix = 0; ix < _symbols; ix++) {
+            if (_sym_dist[ix] == 0) {
+                put_bits(_lit_code[_sym_value[ix]], _lit_len[_sym_value[ix]]);
+                continue;
+            }
+
+            uint32_t len = _sym_value[ix] + MIN_MATCH;
+            uint32_t lsym = length_symbol(len);
+            put_bits(_lit_code[257 + lsym], _lit_len[257 + lsym]);
+            put_bits(len - length_base(lsym), length_extra(lsym));
+
+            uint32_t dist = _sym_dist[ix];
+            uint32_t dsym = dist_symbol(dist);
+            put_bits(_dist_code[dsym], _dist_len[dsym]);
+            put_bits(dist - dist_base(dsym), dist_extra(dsym));
+        }
+        put_bits(_lit_code[256], _lit_len[256]);
+    }
+
+    // Run-length encodes code lengths with the symbols 16-18. Counts the symbols into freq, or writes them with code/len.
+    void encode_lengths(const uint8_t* lengths, uint32_t n, uint16_t* freq, const uint16_t* code, const uint8_t* len) {
+        uint32_t ix = 0;
+        while (ix < n) {
+            uint8_t value = lengths[ix];
+            uint32_t run = 1;
+            while (ix + run < n && lengths[ix + run] == value && run < 138) {
+                run++;
+            }
+
+            if (value == 0 && run >= 11) {
+                put_length(18, run - 11, 7, freq, code, len);
+            }
+            else if (value == 0 && run >= 3) {
+                put_length(17, run - 3, 3, freq, code, len);
+            }
+            else if (value != 0 && run >= 4) {
+                // the length itself, then 3-6 repeats of it
+                run = run > 7 ? 7 : run;
+                put_length(value, 0, 0, freq, code, len);
+                put_length(16, run - 4, 2, freq, code, len);
+            }
+            else {
+                put_length(value, 0, 0, freq, code, len);
+                run = 1;
+            }
+
+            ix += run;
+        }
+    }
+
+    void put_length(uint32_t sym, uint32_t extra, uint32_t extra_bits, uint16_t* freq, const uint16_t* code, const uint8_t* len) {
+        if (freq) {
+            freq[sym]++;
+            return;
+        }
+        put_bits(code[sym], len[sym]);
+        put_bits(extra, extra_bits);
+    }
+
+    // Huffman code lengths of at most max_bits for the given frequencies
+    void build_lengths(const uint16_t* freq, uint32_t n, uint8_t* lengths, uint32_t max_bits) {
+        memset(lengths, 0, n);
+
+        uint32_t leaves = 0;
+        for (uint32_t sym = 0; sym < n; sym++) {
+            if (freq[sym]) _tree_sym[leaves++] = sym;
+        }
+
+        // a code needs at least two symbols to be complete
+        if (leaves < 2) {
+            uint32_t used = leaves ? _tree_sym[0] : 0;
+            lengths[used] = 1;
+            lengths[used == 0 ? 1 : 0] = 1;
+            return;
+        }
+
+        for (uint32_t scale = 0; ; scale++) {
+            // leaves sorted by weight; lowering the precision of the weights flattens the tree
+            for (uint32_t ix = 0; ix < leaves; ix++) {
+                uint16_t sym = _tree_sym[ix];
+                uint16_t weight = ((freq[sym] - 1) >> scale) + 1;
+                uint32_t jx = ix;
+                while (jx > 0 && _tree_weight[jx - 1] > weight) {
+                    _tree_weight[jx] = _tree_weight[jx - 1];
+                    _tree_sym[jx] = _tree_sym[jx - 1];
+                    jx--;
+                }
+                _tree_weight[jx] = weight;
+                _tree_sym[jx] = sym;
+            }
+
+            // two-queue construction: the leaves come first, the internal nodes are appended in order of weight
+            uint32_t next_leaf = 0;
+            uint32_t next_node = leaves;
+            uint32_t nodes = leaves;
+            while (nodes < 2 * leaves - 1) {
+                for (int child = 0; child < 2; child++) {
+                    uint32_t pick;
+                    if (next_leaf < leaves && (next_node == nodes || _tree_weight[next_leaf] <= _tree_weight[next_node])) {
+                        pick = next_leaf++;
+                    }
+                    else {
+                        pick = next_node++;
+                    }
+                    _tree_parent[pick] = nodes;
+                    _tree_weight[nodes] = (child == 0 ? 0 : _tree_weight[nodes]) + _tree_weight[pick];
+                }
+                nodes++;
+            }
+
+            // parents come after their children, the root is the last node
+            uint32_t max_depth = 0;
+            _tree_depth[nodes - 1] = 0;
+            for (uint32_t ix = nodes - 1; ix > 0; ix--) {
+                _tree_depth[ix - 1] = _tree_depth[_tree_parent[ix - 1]] + 1;
+                if (_tree_depth[ix - 1] > max_depth) max_depth = _tree_depth[ix - 1];
+            }
+
+            if (max_depth <= max_bits) {
+                for (uint32_t ix = 0; ix < leaves; ix++) {
+                    lengths[_tree_sym[ix]] = _tree_depth[ix];
+                }
+                return;
+            }
+        }
+    }
+
+    // Canonical Huffman codes for the given lengths, bit-reversed as they are sent starting with the most significant bit
+    static void build_codes(const uint8_t* lengths, uint32_t n, uint16_t* codes) {
+        uint16_t count[16];
+        uint16_t next[16];
+        memset(count, 0, sizeof(count));
+        for (uint32_t ix = 0; ix < n; ix++) {
+            count[lengths[ix]]++;
+        }
+        count[0] = 0;
+
+        uint32_t code = 0;
+        for (int len = 1; len < 16; len++) {
+            code = (code + count[len - 1]) << 1;
+            next[len] = code;
+        }
+
+        for (uint32_t ix = 0; ix < n; ix++) {
+            uint32_t len = lengths[ix];
+            if (len == 0) continue;
+
+            uint32_t c = next[len]++;
+            uint16_t reversed = 0;
+            for (uint32_t bit = 0; bit < len; bit++) {
+                reversed = (reversed << 1) | ((c >> bit) & 1);
+            }
+            codes[ix] = reversed;
+        }
+    }
+
+    static uint32_t fixed_lit_length(uint32_t sym) {
+        return sym < 144 ? 8 : (sym < 256 ? 9 : (sym < 280 ? 7 : 8));
+    }
+
+    static uint32_t length_base(uint32_t sym) {
+        static const uint16_t base[29] = {
+            3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        return base[sym];
+    }
+
+    static uint32_t length_extra(uint32_t sym) {
+        return (sym >= 8 && sym < 28) ? (sym - 4) / 4 : 0;
+    }
+
+    static uint32_t length_symbol(uint32_t len) {
+        uint32_t sym = 28;
+        while (length_base(sym) > len) sym--;
+        return sym;
+    }
+
+    static uint32_t dist_base(uint32_t sym) {
+        static const uint16_t base[30] = {
+            1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073,
+            4097, 6145, 8193, 12289, 16385, 24577 };
+        return base[sym];
+    }
+
+    static uint32_t dist_extra(uint32_t sym) {
+        return sym >= 4 ? sym / 2 - 1 : 0;
+    }
+
+    static uint32_t dist_symbol(uint32_t dist) {
+        uint32_t sym = 29;
+        while (dist_base(sym) > dist) sym--;
+        return sym;
+    }
+
+    void put_bits(uint32_t value, uint32_t n) {
+        _bitbuf |= value << _bitcnt;
+        _bitcnt += n;
+        while (_bitcnt >= 8) {
+            put_byte(_bitbuf & 0xFF);
+            _bitbuf >>= 8;
+            _bitcnt -= 8;
+        }
+    }
+
+    void put_byte(uint8_t b) {
+        if (_out_ix == _out_size) {
+            flush();
+        }
+        _out[_out_ix++] = b;
+    }
+
+    void flush() {
+        if (_out_ix == 0 || _error != NSAPI_ERROR_OK) {
+            _out_ix = 0;
+            return;
+        }
+
+        nsapi_size_or_error_t ret = _output(_out, _out_ix);
+        if (ret < 0) {
+            _error = ret;
+        }
+        _total_out += _out_ix;
+        _out_ix = 0;
+    }
+
+    deflate_format _format;
+    Callback<nsapi_size_or_error_t(const void*, uint32_t)> _output;
+
+    uint32_t _window_size;
+    uint32_t _hash_bits;
+    uint8_t* _buffer;       // two windows: history and lookahead
+    uint16_t* _head;        // last position of every hash
+    uint32_t _pos;
+    uint32_t _end;
+
+    uint32_t _block_symbols;
+    uint32_t _symbols;
+    uint8_t* _sym_value;    // literal, or match length - 3
+    uint16_t* _sym_dist;    // match distance, 0 for literals
+    uint16_t _lit_freq[LIT_CODES];
+    uint16_t _dist_freq[DIST_CODES];
+    uint8_t _lit_len[FIXED_LIT_CODES];
+    uint8_t _dist_len[DIST_CODES];
+    uint16_t _lit_code[FIXED_LIT_CODES];
+    uint16_t _dist_code[DIST_CODES];
+
+    // scratch space for build_lengths()
+    uint16_t _tree_sym[LIT_CODES];
+    uint16_t _tree_weight[2 * LIT_CODES];
+    uint16_t _tree_parent[2 * LIT_CODES];
+    uint8_t _tree_depth[2 * LIT_CODES];
+
+    uint8_t* _out;
+    uint32_t _out_size;
+    uint32_t _out_ix;
+    uint32_t _bitbuf;
+    uint32_t _bitcnt;
+
+    uint32_t _total_in;
+    uint32_t _total_out;
+    uint32_t _crc;
+    uint32_t _adler_a;
+    uint32_t _adler_b;
+    bool _started;
+
+    nsapi_error_t _error;
+};
+
+#endif // _MBED_HTTP_DEFLATER_H_
@@ -0,0 +1,143 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MBED_HTTP_DOWNLOAD_BASE_H_
+#define _MBED_HTTP_DOWNLOAD_BASE_H_
+
+#include <string>
+#include "mbed.h"
+#include "http_request.h"
+#include "https_request.h"
+
+#ifndef HTTP_DOWNLOAD_MAX_ATTEMPTS
+#define HTTP_DOWNLOAD_MAX_ATTEMPTS 5
+#endif
+
+#ifndef HTTP_DOWNLOAD_RETRY_DELAY
+#define HTTP_DOWNLOAD_RETRY_DELAY 1000
+#endif
+
+using namespace std;
+
+/**
+ * \brief HttpDownloadBase holds what ResumableDownload and SegmentedDownload share: where the resource is,
+ * how its GET requests are created, and how range responses are parsed.
+ */
+class HttpDownloadBase {
+public:
+    virtual ~HttpDownloadBase() {}
+
+    /**
+     * Parse a Content-Range header, e.g. 'bytes 100-199/1000'. The range and the total can be '*' (unknown).
+     *
+     * @param[out] start First byte of the range (0 if not present)
+     * @param[out] total Size of the resource (0 if unknown)
+     * @return false if the value is not a byte range
+     */
+    static bool parse_content_range(HttpStringView value, uint32_t* start, uint32_t* total) {
+        *start = 0;
+        *total = 0;
+
+        if (!value.data || value.length < 6 || strncmp(value.data, "bytes ", 6) != 0) {
+            return false;
+        }
+
+        const char* p = value.data + 6;
+        const char* end = value.data + value.length;
+
+        if (p < end && *p == '*') {
+            p++;
+        }
+        else {
+            *start = parse_number(p, end - p, &p);
+            if (p == end || *p != '-') return false;
+            parse_number(p + 1, end - p - 1, &p);
+        }
+
+        if (p == end || *p != '/') return false;
+        p++;
+        if (p < end && *p != '*') {
+            *total = parse_number(p, end - p, &p);
+        }
+        return true;
+    }
+
+    /**
+     * Parse a decimal number, up to the first character that is not a digit (stored in end if not NULL).
+     */
+    static uint32_t parse_number(const char* data, uint32_t length, const char** end) {
+        uint32_t value = 0;
+        uint32_t ix = 0;
+        for (; ix < length && data[ix] >= '0' && data[ix] <= '9'; ix++) {
+            value = value * 10 + (data[ix] - '0');
+        }
+        if (end) {
+            *end = data + ix;
+        }
+        return value;
+    }
+
+    /**
+     * Get the validator to send in If-Range: the ETag of the response, or its Last-Modified date if the ETag
+     * is missing or weak (If-Range needs a strong validator).
+     *
+     * @return The header value, data is NULL if the response has neither
+     */
+    static HttpStringView get_validator(HttpResponse* res) {
+        HttpStringView value = res->get_header(HTTP_HEADER_ETAG);
+        if (!value.data || (value.length >= 2 && value.data[0] == 'W' && value.data[1] == '/')) {
+            value = res->get_header(HTTP_HEADER_LAST_MODIFIED);
+        }
+        return value;
+    }
+
+protected:
+    /**
+     * HttpDownloadBase Constructor
+     *
+     * @param[in] network The network interface
+     * @param[in] url URL to the resource
+     * @param[in] ssl_ca_pem String containing the trusted CAs for https:// URLs, or NULL
+     * @param[in] ca_store Store containing the trusted CAs for https:// URLs, or NULL
+     */
+    HttpDownloadBase(NetworkInterface* network, const char* url, const char* ssl_ca_pem, CertificateStore* ca_store)
+        : _network(network), _url(url), _ssl_ca_pem(ssl_ca_pem), _ca_store(ca_store)
+    {}
+
+    /**
+     * Create a GET request for the resource. Override to send the requests in another way,
+     * e.g. over a socket of your own.
+     *
+     * @param body_cb Callback that needs to receive the response body
+     */
+    virtual HttpRequestBase* create_request(Callback<void(const char*, uint32_t)> body_cb) {
+        if (_ca_store) {
+            return new HttpsRequest(_network, _ca_store, HTTP_GET, _url.c_str(), body_cb);
+        }
+        if (_ssl_ca_pem) {
+            return new HttpsRequest(_network, _ssl_ca_pem, HTTP_GET, _url.c_str(), body_cb);
+        }
+        return new HttpRequest(_network, HTTP_GET, _url.c_str(), body_cb);
+    }
+
+    NetworkInterface* _network;
+    string _url;
+    const char* _ssl_ca_pem;
+    CertificateStore* _ca_store;
+};
+
+#endif // _MBED_HTTP_DOWNLOAD_BASE_H_
@@ -0,0 +1,686 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MBED_HTTP_INFLATER_H_
+#define _MBED_HTTP_INFLATER_H_
+
+#include "mbed.h"
+
+#ifndef HTTP_INFLATE_WINDOW_SIZE
+#define HTTP_INFLATE_WINDOW_SIZE 32768
+#endif
+
+/**
+ * \brief HttpInflater decodes a gzip or deflate (zlib, or raw deflate) stream, as it comes in.
+ *
+ * Input can be split anywhere, the bytes of a code that straddles two writes are carried over.
+ * Decoded data is kept in a window of a fixed size (needed for back-references), and is handed
+ * to the output callback straight from the window: whenever the window wraps, and at the end of every write().
+ *
+ * The window needs to be as large as the one the server compresses with (32K for gzip and deflate),
+ * smaller windows fail on streams that refer back further than the window.
+ */
+class HttpInflater {
+public:
+    enum inflate_format {
+        INFLATE_GZIP,       // gzip (RFC 1952)
+        INFLATE_DEFLATE     // zlib (RFC 1950), or raw deflate (RFC 1951) as sent by some servers
+    };
+
+    /**
+     * HttpInflater Constructor
+     *
+     * @param[in] format Format of the stream
+     * @param[in] output Callback that receives the decoded data
+     * @param[in] window_size Size of the window in bytes
+     */
+    HttpInflater(inflate_format format, Callback<void(const char *at, uint32_t length)> output,
+                 uint32_t window_size = HTTP_INFLATE_WINDOW_SIZE)
+        : _format(format), _output(output), _window_size(window_size),
+          _wpos(0), _flushed(0), _total_out(0), _total_in(0),
+          _input(NULL), _input_size(0), _pos(0), _carry_size(0), _bitbuf(0), _bitcnt(0),
+          _state(format == INFLATE_GZIP ? ST_GZIP_HEADER : ST_ZLIB_HEADER), _count(0), _flags(0), _final(false), _raw(false),
+          _crc(0xFFFFFFFF), _adler_a(1), _adler_b(0), _error(NSAPI_ERROR_OK)
+    {
+        _window = (char*)malloc(window_size);
+        if (!_window) {
+            _error = NSAPI_ERROR_NO_MEMORY;
+        }
+    }
+
+    ~HttpInflater() {
+        free(_window);
+    }
+
+    /**
+     * Decode the next part of the stream. Data after the end of the stream is ignored.
+     *
+     * @return NSAPI_ERROR_OK, -2102 if the stream is corrupt, or NSAPI_ERROR_NO_MEMORY
+     */
+    nsapi_error_t write(const char* data, uint32_t size) {
+        if (_error != NSAPI_ERROR_OK) {
+            return _error;
+        }
+
+        _total_in += size;
+        _input = (const uint8_t*)data;
+        _input_size = size;
+        _pos = 0;
+
+        while (_state != ST_DONE) {
+            uint32_t pos = _pos;
+            uint32_t bitbuf = _bitbuf;
+            uint32_t bitcnt = _bitcnt;
+
+            int ret = step();
+            if (ret == STEP_NEED_INPUT) {
+                // roll back to the start of the step, it's retried when more data comes in
+                _pos = pos;
+                _bitbuf = bitbuf;
+                _bitcnt = bitcnt;
+                break;
+            }
+            if (ret == STEP_ERROR) {
+                _error = -2102;
+                break;
+            }
+        }
+
+        // keep the bytes of the step that did not complete
+        uint32_t left = _carry_size + _input_size - _pos;
+        if (_state == ST_DONE || _error != NSAPI_ERROR_OK) {
+            left = 0;
+        }
+        else if (left > sizeof(_carry)) {
+            _error = -2102;
+            left = 0;
+        }
+
+        uint8_t carry[sizeof(_carry)];
+        for (uint32_t ix = 0; ix < left; ix++) {
+            carry[ix] = byte_at(_pos + ix);
+        }
+        memcpy(_carry, carry, left);
+        _carry_size = left;
+        _input = NULL;
+        _input_size = 0;
+        _pos = 0;
+
+        flush();
+
+        return _error;
+    }
+
+    /**
+     * Call when all input was written.
+     *
+     * @return NSAPI_ERROR_OK if the stream was complete and its checksum matched, an error otherwise
+     */
+    nsapi_error_t finish() {
+        if (_error == NSAPI_ERROR_OK && _state != ST_DONE) {
+            _error = -2102;
+        }
+        return _error;
+    }
+
+    /**
+     * Whether the end of the stream was reached.
+     */
+    bool is_done() {
+        return _state == ST_DONE;
+    }
+
+    nsapi_error_t get_error() {
+        return _error;
+    }
+
+    /**
+     * Number of compressed bytes written into the inflater.
+     */
+    uint32_t get_compressed_bytes() {
+        return _total_in;
+    }
+
+    /**
+     * Number of decompressed bytes produced.
+     */
+    uint32_t get_decompressed_bytes() {
+        return _total_out;
+    }
+
+    // CRC-32 as used by gzip, start with 0xFFFFFFFF and invert the result
+    static uint32_t crc32_update(uint32_t crc, uint8_t c) {
+        static const uint32_t crc_table[16] = {
+            0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+            0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+        };
+        crc ^= c;
+        crc = (crc >> 4) ^ crc_table[crc & 0xF];
+        crc = (crc >> 4) ^ crc_table[crc & 0xF];
+        return crc;
+    }
+
+    // Adler-32 as used by zlib, start with a = 1 and b = 0, the result is (b << 16) | a
+    static void adler32_update(uint32_t* a, uint32_t* b, uint8_t c) {
+        *a += c;
+        if (*a >= 65521) *a -= 65521;
+        *b += *a;
+        if (*b >= 65521) *b -= 65521;
+    }
+
+private:
+    enum inflate_state {
+        ST_GZIP_HEADER,
+        ST_GZIP_EXTRA_LENGTH,
+        ST_GZIP_EXTRA,
+        ST_GZIP_NAME,
+        ST_GZIP_COMMENT,
+        ST_GZIP_HEADER_CRC,
+        ST_ZLIB_HEADER,
+        ST_BLOCK_HEADER,
+        ST_STORED_LENGTH,
+        ST_STORED,
+        ST_DYNAMIC_HEADER,
+        ST_DYNAMIC_CODE_LENGTHS,
+        ST_DYNAMIC_LENGTHS,
+        ST_CODES,
+        ST_TRAILER,
+        ST_DONE
+    };
+
+    enum step_result {
+        STEP_OK,
+        STEP_NEED_INPUT,
+        STEP_ERROR
+    };
+
+    struct Huffman {
+        uint16_t count[16];     // number of codes of each length
+        uint16_t symbol[288];   // symbols ordered by code
+    };
+
+    // Takes a byte from the carry-over, then from the current input
+    uint8_t byte_at(uint32_t pos) {
+        return pos < _carry_size ? _carry[pos] : _input[pos - _carry_size];
+    }
+
+    bool next_byte(uint8_t* b) {
+        if (_pos >= _carry_size + _input_size) {
+            return false;
+        }
+        *b = byte_at(_pos++);
+        return true;
+    }
+
+    // Makes sure there are at least n (max. 24) bits in the bit buffer
+    bool need(uint32_t n) {
+        while (_bitcnt < n) {
+            uint8_t b;
+            if (!next_byte(&b)) {
+                return false;
+            }
+            _bitbuf |= (uint32_t)b << _bitcnt;
+            _bitcnt += 8;
+        }
+        return true;
+    }
+
+    // Only call after need(n) returned true
+    uint32_t bits(uint32_t n) {
+        uint32_t value = _bitbuf & ((1UL << n) - 1);
+        _bitbuf >>= n;
+        _bitcnt -= n;
+        return value;
+    }
+
+    void align_to_byte() {
+        bits(_bitcnt & 7);
+    }
+
+    void put_byte(uint8_t c) {
+        if (_wpos == _window_size) {
+            flush();
+            _wpos = 0;
+            _flushed = 0;
+        }
+
+        _window[_wpos++] = c;
+        _total_out++;
+
+        if (_format == INFLATE_GZIP) {
+            _crc = crc32_update(_crc, c);
+        }
+        else {
+            adler32_update(&_adler_a, &_adler_b, c);
+        }
+    }
+
+    void flush() {
+        if (_wpos > _flushed) {
+            _output(_window + _flushed, _wpos - _flushed);
+            _flushed = _wpos;
+        }
+    }
+
+    // Builds a canonical Huffman code (as in zlib's puff.c), returns < 0 if the code is over-subscribed
+    static int build(Huffman* h, const uint8_t* lengths, uint32_t n) {
+        uint16_t offs[16];
+
+        memset(h->count, 0, sizeof(h->count));
+        for (uint32_t sym = 0; sym < n; sym++) {
+            h->count[lengths[sym]]++;
+        }
+        if (h->count[0] == n) {
+            return 0;
+        }
+
+        int left = 1;
+        for (int len = 1; len < 16; len++) {
+            left <<= 1;
+            left -= h->count[len];
+            if (left < 0) {
+                return left;
+            }
+        }
+
+        offs[1] = 0;
+        for (int len = 1; len < 15; len++) {
+            offs[len + 1] = offs[len] + h->count[len];
+        }
+        for (uint32_t sym = 0; sym < n; sym++) {
+            if (lengths[sym] != 0) {
+                h->symbol[offs[lengths[sym]]++] = sym;
+            }
+        }
+        return left;
+    }
+
+    // Returns the next symbol, -1 if more input is needed, -2 on an invalid code
+    int decode(const Huffman* h) {
+        int code = 0, first = 0, index = 0;
+
+        for (int len = 1; len < 16; len++) {
+            if (!need(1)) {
+                return -1;
+            }
+            code |= bits(1);
+
+            int count = h->count[len];
+            if (code - count < first) {
+                return h->symbol[index + (code - first)];
+            }
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+        }
+        return -2;
+    }
+
+    int step() {
+        static const uint8_t code_length_order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+        static const uint16_t length_base[29] = {
+            3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static const uint8_t length_extra[29] = {
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        static const uint16_t dist_base[30] = {
+            1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073,
+            4097, 6145, 8193, 12289, 16385, 24577 };
+        static const uint8_t dist_extra[30] = {
+            0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+        switch (_state) {
+            case ST_GZIP_HEADER: {
+                // ID1 ID2 CM FLG MTIME(4) XFL OS
+                if (!need(8)) return STEP_NEED_INPUT;
+                uint8_t b = bits(8);
+                if ((_count == 0 && b != 0x1F) || (_count == 1 && b != 0x8B) || (_count == 2 && b != 8)) {
+                    return STEP_ERROR;
+                }
+                if (_count == 3) {
+                    _flags = b;
+                }
+                if (++_count == 10) {
+                    _count = 0;
+                    next_gzip_field(ST_GZIP_HEADER);
+                }
+                return STEP_OK;
+            }
+
+            case ST_GZIP_EXTRA_LENGTH:
+                if (!need(16)) return STEP_NEED_INPUT;
+                _count = bits(16);
+                _state = ST_GZIP_EXTRA;
+                return STEP_OK;
+
+            case ST_GZIP_EXTRA:
+                if (_count == 0) {
+                    next_gzip_field(ST_GZIP_EXTRA);
+                    return STEP_OK;
+                }
+                if (!need(8)) return STEP_NEED_INPUT;
+                bits(8);
+                _count--;
+                return STEP_OK;
+
+            case ST_GZIP_NAME:
+            case ST_GZIP_COMMENT: {
+                // zero-terminated
+                if (!need(8)) return STEP_NEED_INPUT;
+                if (bits(8) == 0) {
+                    next_gzip_field(_state);
+                }
+                return STEP_OK;
+            }
+
+            case ST_GZIP_HEADER_CRC:
+                if (!need(16)) return STEP_NEED_INPUT;
+                bits(16);
+                _state = ST_BLOCK_HEADER;
+                return STEP_OK;
+
+            case ST_ZLIB_HEADER: {
+                if (!need(16)) return STEP_NEED_INPUT;
+                uint32_t cmf = _bitbuf & 0xFF;
+                uint32_t flg = (_bitbuf >> 8) & 0xFF;
+                if ((cmf & 0x0F) == 8 && (cmf >> 4) <= 7 && ((cmf << 8) | flg) % 31 == 0) {
+                    if (flg & 0x20) {
+                        // preset dictionary, not used in HTTP
+                        return STEP_ERROR;
+                    }
+                    bits(16);
+                }
+                else {
+                    // no zlib header, raw deflate
+                    _raw = true;
+                }
+                _state = ST_BLOCK_HEADER;
+                return STEP_OK;
+            }
+
+            case ST_BLOCK_HEADER: {
+                if (!need(3)) return STEP_NEED_INPUT;
+                _final = bits(1) == 1;
+                uint32_t type = bits(2);
+                if (type == 0) {
+                    _state = ST_STORED_LENGTH;
+                }
+                else if (type == 1) {
+                    uint8_t lengths[288 + 30];
+                    memset(lengths, 8, 144);
+                    memset(lengths + 144, 9, 112);
+                    memset(lengths + 256, 7, 24);
+                    memset(lengths + 280, 8, 8);
+                    memset(lengths + 288, 5, 30);
+                    build(&_lencode, lengths, 288);
+                    build(&_distcode, lengths + 288, 30);
+                    _state = ST_CODES;
+                }
+                else if (type == 2) {
+                    _state = ST_DYNAMIC_HEADER;
+                }
+                else {
+                    return STEP_ERROR;
+                }
+                return STEP_OK;
+            }
+
+            case ST_STORED_LENGTH: {
+                align_to_byte();
+                if (!need(16)) return STEP_NEED_INPUT;
+                uint32_t len = bits(16);
+                if (!need(16)) return STEP_NEED_INPUT;
+                uint32_t nlen = bits(16);
+                if (len != (~nlen & 0xFFFF)) {
+                    return STEP_ERROR;
+                }
+                _count = len;
+                _state = ST_STORED;
+                return STEP_OK;
+            }
+
+            case ST_STORED: {
+                if (_count == 0) {
+                    _state = _final ? ST_TRAILER : ST_BLOCK_HEADER;
+                    return STEP_OK;
+                }
+                // bytes still in the bit buffer go first
+                if (_bitcnt >= 8) {
+                    put_byte(bits(8));
+                    _count--;
+                    return STEP_OK;
+                }
+                uint8_t b;
+                bool progress = false;
+                while (_count > 0 && next_byte(&b)) {
+                    put_byte(b);
+                    _count--;
+                    progress = true;
+                }
+                return progress || _count == 0 ? STEP_OK : STEP_NEED_INPUT;
+            }
+
+            case ST_DYNAMIC_HEADER:
+                if (!need(14)) return STEP_NEED_INPUT;
+                _nlen = bits(5) + 257;
+                _ndist = bits(5) + 1;
+                _ncode = bits(4) + 4;
+                if (_nlen > 286 || _ndist > 30) {
+                    return STEP_ERROR;
+                }
+                memset(_lengths, 0, sizeof(_lengths));
+                _count = 0;
+                _state = ST_DYNAMIC_CODE_LENGTHS;
+                return STEP_OK;
+
+            case ST_DYNAMIC_CODE_LENGTHS:
+                if (_count < _ncode) {
+                    if (!need(3)) return STEP_NEED_INPUT;
+                    _lengths[code_length_order[_count++]] = bits(3);
+                    return STEP_OK;
+                }
+                if (build(&_lencode, _lengths, 19) != 0) {
+                    // the code length code needs to be complete
+                    return STEP_ERROR;
+                }
+                memset(_lengths, 0, sizeof(_lengths));
+                _count = 0;
+                _state = ST_DYNAMIC_LENGTHS;
+                return STEP_OK;
+
+            case ST_DYNAMIC_LENGTHS: {
+                if (_count < _nlen + _ndist) {
+                    int sym = decode(&_lencode);
+                    if (sym == -1) return STEP_NEED_INPUT;
+                    if (sym < 0) return STEP_ERROR;
+
+                    if (sym < 16) {
+                        _lengths[_count++] = sym;
+                        return STEP_OK;
+                    }
+
+                    uint8_t len = 0;
+                    uint32_t repeat;
+                    if (sym == 16) {
+                        if (_count == 0) return STEP_ERROR;
+                        len = _lengths[_count - 1];
+                        if (!need(2)) return STEP_NEED_INPUT;
+                        repeat = 3 + bits(2);
+                    }
+                    else if (sym == 17) {
+                        if (!need(3)) return STEP_NEED_INPUT;
+                        repeat = 3 + bits(3);
+                    }
+                    else {
+                        if (!need(7)) return STEP_NEED_INPUT;
+                        repeat = 11 + bits(7);
+                    }
+
+                    if (_count + repeat > _nlen + _ndist) {
+                        return STEP_ERROR;
+                    }
+                    while (repeat--) {
+                        _lengths[_count++] = len;
+                    }
+                    return STEP_OK;
+                }
+
+                // there needs to be an end-of-block code
+                if (_lengths[256] == 0) {
+                    return STEP_ERROR;
+                }
+                if (build(&_lencode, _lengths, _nlen) < 0 || build(&_distcode, _lengths + _nlen, _ndist) < 0) {
+                    return STEP_ERROR;
+                }
+                _state = ST_CODES;
+                return STEP_OK;
+            }
+
+            case ST_CODES: {
+                int sym = decode(&_lencode);
+                if (sym == -1) return STEP_NEED_INPUT;
+                if (sym < 0) return STEP_ERROR;
+
+                if (sym < 256) {
+                    put_byte(sym);
+                    return STEP_OK;
+                }
+                if (sym == 256) {
+                    _state = _final ? ST_TRAILER : ST_BLOCK_HEADER;
+                    return STEP_OK;
+                }
+
+                sym -= 257;
+                if (sym >= 29) return STEP_ERROR;
+                if (!need(length_extra[sym])) return STEP_NEED_INPUT;
+                uint32_t len = length_base[sym] + bits(length_extra[sym]);
+
+                int dsym = decode(&_distcode);
+                if (dsym == -1) return STEP_NEED_INPUT;
+                if (dsym < 0 || dsym >= 30) return STEP_ERROR;
+                if (!need(dist_extra[dsym])) return STEP_NEED_INPUT;
+                uint32_t dist = dist_base[dsym] + bits(dist_extra[dsym]);
+
+                if (dist > _total_out || dist > _window_size) {
+                    return STEP_ERROR;
+                }
+
+                while (len--) {
+                    uint32_t from = _wpos + _window_size - dist;
+                    if (from >= _window_size) {
+                        from -= _window_size;
+                    }
+                    put_byte(_window[from]);
+                }
+                return STEP_OK;
+            }
+
+            case ST_TRAILER: {
+                align_to_byte();
+                if (_format == INFLATE_GZIP) {
+                    // CRC32 and ISIZE, little endian
+                    if (!need(16)) return STEP_NEED_INPUT;
+                    uint32_t crc = bits(16);
+                    if (!need(16)) return STEP_NEED_INPUT;
+                    crc |= bits(16) << 16;
+                    if (!need(16)) return STEP_NEED_INPUT;
+                    uint32_t isize = bits(16);
+                    if (!need(16)) return STEP_NEED_INPUT;
+                    isize |= bits(16) << 16;
+
+                    if (crc != (_crc ^ 0xFFFFFFFF) || isize != _total_out) {
+                        return STEP_ERROR;
+                    }
+                }
+                else if (!_raw) {
+                    // Adler-32, big endian
+                    uint32_t adler = 0;
+                    for (int ix = 0; ix < 4; ix++) {
+                        if (!need(8)) return STEP_NEED_INPUT;
+                        adler = (adler << 8) | bits(8);
+                    }
+                    if (adler != ((_adler_b << 16) | _adler_a)) {
+                        return STEP_ERROR;
+                    }
+                }
+                _state = ST_DONE;
+                return STEP_OK;
+            }
+
+            default:
+                return STEP_ERROR;
+        }
+    }
+
+    // Moves to the next optional gzip header field after the given one, or to the first block
+    void next_gzip_field(inflate_state after) {
+        if (after < ST_GZIP_EXTRA_LENGTH && (_flags & 0x04)) {
+            _state = ST_GZIP_EXTRA_LENGTH;
+        }
+        else if (after < ST_GZIP_NAME && (_flags & 0x08)) {
+            _state = ST_GZIP_NAME;
+        }
+        else if (after < ST_GZIP_COMMENT && (_flags & 0x10)) {
+            _state = ST_GZIP_COMMENT;
+        }
+        else if (after < ST_GZIP_HEADER_CRC && (_flags & 0x02)) {
+            _state = ST_GZIP_HEADER_CRC;
+        }
+        else {
+            _state = ST_BLOCK_HEADER;
+        }
+    }
+
+    inflate_format _format;
+    Callback<void(const char *at, uint32_t length)> _output;
+
+    char* _window;
+    uint32_t _window_size;
+    uint32_t _wpos;         // write position in the window
+    uint32_t _flushed;      // window data before this position was handed to the output
+    uint32_t _total_out;
+    uint32_t _total_in;
+
+    const uint8_t* _input;
+    uint32_t _input_size;
+    uint32_t _pos;          // read position in carry-over + input
+    uint8_t _carry[16];
+    uint32_t _carry_size;
+    uint32_t _bitbuf;
+    uint32_t _bitcnt;
+
+    inflate_state _state;
+    uint32_t _count;
+    uint8_t _flags;
+    bool _final;
+    bool _raw;
+
+    uint32_t _nlen;
+    uint32_t _ndist;
+    uint32_t _ncode;
+    uint8_t _lengths[286 + 30];
+    Huffman _lencode;
+    Huffman _distcode;
+
+    uint32_t _crc;
+    uint32_t _adler_a;
+    uint32_t _adler_b;
+
+    nsapi_error_t _error;
+};
+
+#endif // _MBED_HTTP_INFLATER_H_
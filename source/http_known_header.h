@@ -0,0 +1,183 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MBED_HTTP_KNOWN_HEADER_H_
+#define _MBED_HTTP_KNOWN_HEADER_H_
+
+#include <stdint.h>
+
+#if __cplusplus >= 201103L
+#define HTTP_KNOWN_HEADER_CONSTEXPR constexpr
+#else
+#define HTTP_KNOWN_HEADER_CONSTEXPR
+#endif
+
+/**
+ * Standard response headers, HttpResponse tags every header with one of these while parsing.
+ */
+enum http_known_header {
+    HTTP_HEADER_CONTENT_LENGTH = 0,
+    HTTP_HEADER_CONTENT_TYPE,
+    HTTP_HEADER_CONTENT_ENCODING,
+    HTTP_HEADER_CONTENT_RANGE,
+    HTTP_HEADER_TRANSFER_ENCODING,
+    HTTP_HEADER_CONNECTION,
+    HTTP_HEADER_ETAG,
+    HTTP_HEADER_LAST_MODIFIED,
+    HTTP_HEADER_CACHE_CONTROL,
+    HTTP_HEADER_LOCATION,
+    HTTP_HEADER_DATE,
+    HTTP_HEADER_ACCEPT_RANGES,
+    HTTP_HEADER_AGE,
+    HTTP_HEADER_ALLOW,
+    HTTP_HEADER_CONTENT_DISPOSITION,
+    HTTP_HEADER_CONTENT_LANGUAGE,
+    HTTP_HEADER_CONTENT_LOCATION,
+    HTTP_HEADER_EXPIRES,
+    HTTP_HEADER_KEEP_ALIVE,
+    HTTP_HEADER_LINK,
+    HTTP_HEADER_PRAGMA,
+    HTTP_HEADER_PROXY_AUTHENTICATE,
+    HTTP_HEADER_RETRY_AFTER,
+    HTTP_HEADER_SERVER,
+    HTTP_HEADER_SET_COOKIE,
+    HTTP_HEADER_STRICT_TRANSPORT_SECURITY,
+    HTTP_HEADER_TRAILER,
+    HTTP_HEADER_UPGRADE,
+    HTTP_HEADER_VARY,
+    HTTP_HEADER_VIA,
+    HTTP_HEADER_WWW_AUTHENTICATE,
+    HTTP_HEADER_X_CONTENT_TYPE_OPTIONS,
+    HTTP_HEADER_X_FRAME_OPTIONS,
+    HTTP_HEADER_ACCESS_CONTROL_ALLOW_ORIGIN,
+    HTTP_HEADER_KNOWN_COUNT,
+    HTTP_HEADER_UNKNOWN = HTTP_HEADER_KNOWN_COUNT
+};
+
+// lower-case names, by http_known_header
+static HTTP_KNOWN_HEADER_CONSTEXPR const char* const http_known_header_names[HTTP_HEADER_KNOWN_COUNT] = {
+    "content-length",
+    "content-type",
+    "content-encoding",
+    "content-range",
+    "transfer-encoding",
+    "connection",
+    "etag",
+    "last-modified",
+    "cache-control",
+    "location",
+    "date",
+    "accept-ranges",
+    "age",
+    "allow",
+    "content-disposition",
+    "content-language",
+    "content-location",
+    "expires",
+    "keep-alive",
+    "link",
+    "pragma",
+    "proxy-authenticate",
+    "retry-after",
+    "server",
+    "set-cookie",
+    "strict-transport-security",
+    "trailer",
+    "upgrade",
+    "vary",
+    "via",
+    "www-authenticate",
+    "x-content-type-options",
+    "x-frame-options",
+    "access-control-allow-origin"
+};
+
+static const uint32_t HTTP_KNOWN_HEADER_MIN_LENGTH = 3;
+static const uint32_t HTTP_KNOWN_HEADER_MAX_LENGTH = 27;
+
+/**
+ * Perfect hash over the names above: length, first, second and last character (case-folded).
+ * Every name lands in its own slot of http_known_header_slots, so a lookup is one hash
+ * and one compare. When adding a name, pick new factors so there are no collisions again,
+ * C++11 builds check this at compile time.
+ */
+static HTTP_KNOWN_HEADER_CONSTEXPR inline uint32_t http_known_header_hash(const char* name, uint32_t length) {
+    return (length + 4 * (uint8_t)(name[0] | 0x20) + 8 * (uint8_t)(name[1] | 0x20) + (uint8_t)(name[length - 1] | 0x20)) & 63;
+}
+
+static HTTP_KNOWN_HEADER_CONSTEXPR const uint8_t http_known_header_slots[64] = {
+    HTTP_HEADER_UPGRADE, HTTP_HEADER_DATE, HTTP_HEADER_CONTENT_LOCATION, HTTP_HEADER_KEEP_ALIVE,
+    HTTP_HEADER_VIA, HTTP_HEADER_CONTENT_DISPOSITION, HTTP_HEADER_UNKNOWN, HTTP_HEADER_PROXY_AUTHENTICATE,
+    HTTP_HEADER_UNKNOWN, HTTP_HEADER_WWW_AUTHENTICATE, HTTP_HEADER_X_FRAME_OPTIONS, HTTP_HEADER_UNKNOWN,
+    HTTP_HEADER_UNKNOWN, HTTP_HEADER_CACHE_CONTROL, HTTP_HEADER_EXPIRES, HTTP_HEADER_UNKNOWN,
+    HTTP_HEADER_UNKNOWN, HTTP_HEADER_X_CONTENT_TYPE_OPTIONS, HTTP_HEADER_UNKNOWN, HTTP_HEADER_UNKNOWN,
+    HTTP_HEADER_UNKNOWN, HTTP_HEADER_UNKNOWN, HTTP_HEADER_UNKNOWN, HTTP_HEADER_UNKNOWN,
+    HTTP_HEADER_TRANSFER_ENCODING, HTTP_HEADER_TRAILER, HTTP_HEADER_UNKNOWN, HTTP_HEADER_UNKNOWN,
+    HTTP_HEADER_ACCEPT_RANGES, HTTP_HEADER_VARY, HTTP_HEADER_LOCATION, HTTP_HEADER_ETAG,
+    HTTP_HEADER_ALLOW, HTTP_HEADER_UNKNOWN, HTTP_HEADER_UNKNOWN, HTTP_HEADER_SET_COOKIE,
+    HTTP_HEADER_AGE, HTTP_HEADER_ACCESS_CONTROL_ALLOW_ORIGIN, HTTP_HEADER_UNKNOWN, HTTP_HEADER_LINK,
+    HTTP_HEADER_UNKNOWN, HTTP_HEADER_LAST_MODIFIED, HTTP_HEADER_UNKNOWN, HTTP_HEADER_UNKNOWN,
+    HTTP_HEADER_SERVER, HTTP_HEADER_RETRY_AFTER, HTTP_HEADER_UNKNOWN, HTTP_HEADER_UNKNOWN,
+    HTTP_HEADER_UNKNOWN, HTTP_HEADER_UNKNOWN, HTTP_HEADER_UNKNOWN, HTTP_HEADER_UNKNOWN,
+    HTTP_HEADER_UNKNOWN, HTTP_HEADER_CONTENT_TYPE, HTTP_HEADER_CONTENT_RANGE, HTTP_HEADER_PRAGMA,
+    HTTP_HEADER_UNKNOWN, HTTP_HEADER_CONTENT_LANGUAGE, HTTP_HEADER_CONTENT_LENGTH, HTTP_HEADER_CONTENT_ENCODING,
+    HTTP_HEADER_CONNECTION, HTTP_HEADER_UNKNOWN, HTTP_HEADER_STRICT_TRANSPORT_SECURITY, HTTP_HEADER_UNKNOWN
+};
+
+#if __cplusplus >= 201103L
+constexpr uint32_t http_known_header_length(const char* name) {
+    return *name ? 1 + http_known_header_length(name + 1) : 0;
+}
+
+constexpr bool http_known_header_slots_valid(uint32_t id) {
+    return id == HTTP_HEADER_KNOWN_COUNT ||
+        (http_known_header_slots[http_known_header_hash(http_known_header_names[id], http_known_header_length(http_known_header_names[id]))] == id &&
+         http_known_header_length(http_known_header_names[id]) >= HTTP_KNOWN_HEADER_MIN_LENGTH &&
+         http_known_header_length(http_known_header_names[id]) <= HTTP_KNOWN_HEADER_MAX_LENGTH &&
+         http_known_header_slots_valid(id + 1));
+}
+
+static_assert(http_known_header_slots_valid(0), "http_known_header_slots does not match http_known_header_names");
+#endif
+
+/**
+ * Find the standard header with this name (case-insensitive).
+ *
+ * @return The header, or HTTP_HEADER_UNKNOWN
+ */
+static inline http_known_header http_lookup_known_header(const char* name, uint32_t length) {
+    if (length < HTTP_KNOWN_HEADER_MIN_LENGTH || length > HTTP_KNOWN_HEADER_MAX_LENGTH) {
+        return HTTP_HEADER_UNKNOWN;
+    }
+
+    uint8_t id = http_known_header_slots[http_known_header_hash(name, length)];
+    if (id == HTTP_HEADER_UNKNOWN) {
+        return HTTP_HEADER_UNKNOWN;
+    }
+
+    const char* known = http_known_header_names[id];
+    for (uint32_t ix = 0; ix < length; ix++) {
+        char c = name[ix];
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        if (known[ix] == '\0' || c != known[ix]) {
+            return HTTP_HEADER_UNKNOWN;
+        }
+    }
+    return known[length] == '\0' ? (http_known_header)id : HTTP_HEADER_UNKNOWN;
+}
+
+#endif // _MBED_HTTP_KNOWN_HEADER_H_
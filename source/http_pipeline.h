@@ -0,0 +1,221 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MBED_HTTP_PIPELINE_H_
+#define _MBED_HTTP_PIPELINE_H_
+
+#include <vector>
+#include "mbed.h"
+#include "http_request_base.h"
+
+using namespace std;
+
+/**
+ * \brief HttpPipeline sends several requests back-to-back over one connection (HTTP/1.1 pipelining),
+ * before reading any of the responses.
+ *
+ * The responses come back in the order the requests were sent, and are parsed by a single parser that
+ * runs across message boundaries. Every response is stored on its own request object.
+ *
+ * All requests need to be constructed with the (connected) socket that is passed to the pipeline.
+ * Only pipeline idempotent requests (GET, HEAD, PUT, DELETE): if the connection drops, there's no way
+ * to know which requests were processed by the server.
+ */
+class HttpPipeline {
+public:
+    /**
+     * HttpPipeline Constructor
+     *
+     * @param[in] socket A connected socket, the same one that was passed to the requests
+     */
+    HttpPipeline(Socket* socket)
+        : _socket(socket), _current(0), _parser(NULL)
+    {}
+
+    /**
+     * Add a request to the pipeline.
+     *
+     * @param request The request, needs to stay alive until the pipeline was sent
+     * @param body Pointer to the body to be sent
+     * @param body_size Size of the body to be sent
+     */
+    void add(HttpRequestBase* request, const void* body = NULL, nsapi_size_t body_size = 0) {
+        Item item;
+        item.request = request;
+        item.body = body;
+        item.body_size = body_size;
+        _items.push_back(item);
+    }
+
+    /**
+     * Send all requests, then receive all responses.
+     * Afterwards use get_response() to get the response for every request.
+     *
+     * @return NSAPI_ERROR_OK if all responses were received, or the first error that occurred.
+     *         Requests that did not get a response (or whose body could not be decoded or stored) have their error set,
+     *         see HttpRequestBase::get_error().
+     */
+    nsapi_error_t send() {
+        for (size_t ix = 0; ix < _items.size(); ix++) {
+            HttpRequestBase* req = _items[ix].request;
+
+            if (req->_response != NULL) {
+                // already executed this request
+                return fail_from(0, -2100);
+            }
+            if (req->_we_created_socket || req->_socket != _socket) {
+                return fail_from(0, NSAPI_ERROR_PARAMETER);
+            }
+        }
+
+        // first write all requests...
+        for (size_t ix = 0; ix < _items.size(); ix++) {
+            HttpRequestBase* req = _items[ix].request;
+
+            req->_request_buffer_ix = 0;
+
+            uint32_t request_size = 0;
+            char* request = req->_request_builder->build_headers(_items[ix].body_size, request_size);
+            if (!request) {
+                return fail_from(0, NSAPI_ERROR_NO_MEMORY);
+            }
+
+            nsapi_size_or_error_t ret = req->send_buffer(request, request_size);
+
+            if (ret >= 0 && _items[ix].body_size > 0) {
+                ret = req->send_buffer((char*)_items[ix].body, _items[ix].body_size);
+            }
+
+            if (ret < 0) {
+                // responses to the requests that were written can't be read anymore either
+                return fail_from(0, ret);
+            }
+        }
+
+        if (_items.size() == 0) {
+            return NSAPI_ERROR_OK;
+        }
+
+        // ...then read all responses with one parser, it switches to the next response when a message completes
+        _current = 0;
+        HttpRequestBase* first = _items[0].request;
+        first->_response = new HttpResponse();
+
+        HttpParser parser(first->_response, HTTP_RESPONSE, first->_body_callback);
+        parser.setContentDecoding(first->_content_decoding);
+        parser.setSkipBody(first->_request_builder->get_method() == HTTP_HEAD);
+        parser.setHeaderCompleteCallBack(first->_headers_callback);
+        parser.setMessageCompleteCallBack(callback(this, &HttpPipeline::on_message_complete));
+        _parser = &parser;
+
+        // the first request's receive buffer settings (pool, caller buffer) apply to the whole pipeline
+        uint32_t recv_buffer_size;
+        uint8_t* recv_buffer = first->acquire_receive_buffer(&recv_buffer_size);
+        if (!recv_buffer) {
+            _parser = NULL;
+            return fail_from(0, NSAPI_ERROR_NO_MEMORY);
+        }
+
+        nsapi_size_or_error_t recv_ret = 0;
+        while (_current < _items.size() && (recv_ret = _socket->recv(recv_buffer, recv_buffer_size)) > 0) {
+            uint32_t nparsed = parser.execute((const char*)recv_buffer, recv_ret);
+            if (nparsed != (uint32_t)recv_ret) {
+                recv_ret = -2101;
+                break;
+            }
+        }
+
+        // responses without Content-Length end when the connection closes
+        if (recv_ret == 0 && _current < _items.size()) {
+            parser.finish();
+        }
+
+        first->release_receive_buffer(recv_buffer);
+        _parser = NULL;
+
+        if (_current < _items.size()) {
+            return fail_from(_current, recv_ret < 0 ? recv_ret : NSAPI_ERROR_CONNECTION_LOST);
+        }
+
+        return NSAPI_ERROR_OK;
+    }
+
+    /**
+     * Get the response for a request, in the order they were added.
+     *
+     * @return The response (owned by the request), or NULL if it was not (completely) received
+     */
+    HttpResponse* get_response(size_t ix) {
+        if (ix >= _items.size()) {
+            return NULL;
+        }
+
+        HttpResponse* res = _items[ix].request->_response;
+        if (res == NULL || !res->is_message_complete()) {
+            return NULL;
+        }
+        return res;
+    }
+
+private:
+    struct Item {
+        HttpRequestBase* request;
+        const void* body;
+        nsapi_size_t body_size;
+    };
+
+    void on_message_complete(HttpResponse* /*response*/) {
+        nsapi_error_t body_ret = _parser->getContentDecodingError();
+        if (body_ret == NSAPI_ERROR_OK) {
+            body_ret = _items[_current].request->_response->get_body_error();
+        }
+        if (body_ret == NSAPI_ERROR_OK) {
+            body_ret = _items[_current].request->complete_body_sink();
+        }
+        if (body_ret != NSAPI_ERROR_OK) {
+            _items[_current].request->_error = body_ret;
+        }
+
+        _current++;
+
+        if (_current < _items.size()) {
+            HttpRequestBase* next = _items[_current].request;
+            next->_response = new HttpResponse();
+            _parser->setResponse(next->_response);
+            _parser->setBodyCallBack(next->_body_callback);
+            _parser->setHeaderCompleteCallBack(next->_headers_callback);
+            _parser->setContentDecoding(next->_content_decoding);
+            // a HEAD response ends after the headers, the next response starts right after it
+            _parser->setSkipBody(next->_request_builder->get_method() == HTTP_HEAD);
+        }
+    }
+
+    // sets the error on the request at ix, and on all the ones after it
+    nsapi_error_t fail_from(size_t ix, nsapi_error_t error) {
+        for (; ix < _items.size(); ix++) {
+            _items[ix].request->_error = error;
+        }
+        return error;
+    }
+
+    Socket* _socket;
+    vector<Item> _items;
+    size_t _current;
+    HttpParser* _parser;
+};
+
+#endif // _MBED_HTTP_PIPELINE_H_
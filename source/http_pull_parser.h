@@ -0,0 +1,412 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MBED_HTTP_PULL_PARSER_H_
+#define _MBED_HTTP_PULL_PARSER_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include "http_parser.h"
+#include "http_response.h"
+
+#ifndef HTTP_PULL_PARSER_CARRY_SIZE
+#define HTTP_PULL_PARSER_CARRY_SIZE 128
+#endif
+
+enum http_pull_event_type {
+    HTTP_PULL_NEED_DATA = 0,    // everything passed to feed() is consumed
+    HTTP_PULL_STATUS,           // status line, code in get_status_code(), reason phrase in value
+    HTTP_PULL_HEADER,           // header (or trailer) in name and value
+    HTTP_PULL_HEADERS_COMPLETE, // end of the headers, the body follows
+    HTTP_PULL_BODY,             // piece of the body in value
+    HTTP_PULL_MESSAGE_COMPLETE, // end of the response, the next one may follow on the same connection
+    HTTP_PULL_ERROR             // parse error, see get_error()
+};
+
+struct HttpPullEvent {
+    http_pull_event_type type;
+    http_known_header header; // HTTP_PULL_HEADER: the standard header, or HTTP_HEADER_UNKNOWN
+    HttpStringView name;
+    HttpStringView value;
+};
+
+/**
+ * Response parser that hands out events instead of calling back and copying.
+ *
+ * Pass received data in with feed() and call next() until it returns HTTP_PULL_NEED_DATA.
+ * The names, values and body pieces in the events point into the buffer passed to feed(),
+ * which has to stay untouched until then. Only a status line or header that is split over
+ * two feed() calls is copied into a small carry-over buffer, events point there instead.
+ * Either way they are valid until the next call to next().
+ *
+ * Bodies are reported as they arrive (chunked encoding removed, not decompressed).
+ * Folded (multi-line) header values are reported as several HTTP_PULL_HEADER events
+ * with the same name.
+ */
+class HttpPullParser {
+public:
+    HttpPullParser()
+        : _data(NULL), _length(0), _offset(0), _finished(false), _finish_done(false),
+          _event_count(0), _event_next(0), _status_reported(false),
+          _has_name(false), _name_data(NULL), _name_offset(0), _name_length(0),
+          _partial(false), _partial_offset(0), _partial_length(0),
+          _carry(NULL), _carry_length(0), _carry_capacity(0)
+    {
+        memset(&_settings, 0, sizeof(_settings));
+        _settings.on_status = &HttpPullParser::on_status_callback;
+        _settings.on_header_field = &HttpPullParser::on_header_field_callback;
+        _settings.on_header_value = &HttpPullParser::on_header_value_callback;
+        _settings.on_headers_complete = &HttpPullParser::on_headers_complete_callback;
+        _settings.on_body = &HttpPullParser::on_body_callback;
+        _settings.on_message_complete = &HttpPullParser::on_message_complete_callback;
+
+        http_parser_init(&_parser, HTTP_RESPONSE);
+        _parser.data = (void*)this;
+    }
+
+    ~HttpPullParser() {
+        if (_carry) {
+            free(_carry);
+        }
+    }
+
+    /**
+     * Hand the next piece of the response to the parser.
+     * Only call this after next() returned HTTP_PULL_NEED_DATA.
+     */
+    void feed(const char* data, uint32_t length) {
+        _data = data;
+        _length = length;
+        _offset = 0;
+    }
+
+    /**
+     * The connection was closed, ends a response that is delimited by the end of the connection.
+     */
+    void finish() {
+        _finished = true;
+    }
+
+    /**
+     * Parse up to the next event.
+     *
+     * @param event Filled in with the event
+     * @returns The type of the event
+     */
+    http_pull_event_type next(HttpPullEvent* event) {
+        while (_event_next == _event_count) {
+            _event_next = _event_count = 0;
+
+            if (HTTP_PARSER_ERRNO(&_parser) != HPE_OK) {
+                event->type = HTTP_PULL_ERROR;
+                return event->type;
+            }
+
+            if (_offset < _length) {
+                uint32_t consumed = http_parser_execute(&_parser, &_settings, _data + _offset, _length - _offset);
+                _offset += consumed;
+
+                // only an upgrade stops the parser without an event or an error, that's not supported
+                if (consumed == 0 && _event_count == 0 && HTTP_PARSER_ERRNO(&_parser) == HPE_OK) {
+                    _parser.http_errno = HPE_UNKNOWN;
+                }
+            }
+            else if (_finished && !_finish_done) {
+                _finish_done = true;
+                http_parser_execute(&_parser, &_settings, NULL, 0);
+            }
+            else {
+                // the caller is about to re-use the buffer
+                if (!keep_name()) {
+                    _parser.http_errno = HPE_UNKNOWN;
+                    continue;
+                }
+                event->type = HTTP_PULL_NEED_DATA;
+                return event->type;
+            }
+
+            if (HTTP_PARSER_ERRNO(&_parser) == HPE_PAUSED) {
+                http_parser_pause(&_parser, 0);
+            }
+        }
+
+        *event = _events[_event_next++];
+        return event->type;
+    }
+
+    int get_status_code() {
+        return _parser.status_code;
+    }
+
+    /**
+     * Whether the connection can be re-used after the current response.
+     * Only meaningful after HTTP_PULL_MESSAGE_COMPLETE.
+     */
+    bool should_keep_alive() {
+        return http_should_keep_alive(&_parser) != 0;
+    }
+
+    /**
+     * The parse error after HTTP_PULL_ERROR, see http_errno_description() for a message.
+     */
+    http_errno get_error() {
+        return HTTP_PARSER_ERRNO(&_parser);
+    }
+
+private:
+    void push_event(http_pull_event_type type, HttpStringView name, HttpStringView value) {
+        HttpPullEvent& event = _events[_event_count++];
+        event.type = type;
+        event.header = type == HTTP_PULL_HEADER ? http_lookup_known_header(name.data, name.length) : HTTP_HEADER_UNKNOWN;
+        event.name = name;
+        event.value = value;
+
+        // makes http_parser_execute() return right after this callback
+        http_parser_pause(&_parser, 1);
+    }
+
+    void push_event(http_pull_event_type type) {
+        HttpStringView none = { "", 0 };
+        push_event(type, none, none);
+    }
+
+    // a response without a reason phrase has no status callback, report it before the first header
+    void report_status() {
+        if (!_status_reported) {
+            _status_reported = true;
+            push_event(HTTP_PULL_STATUS);
+        }
+    }
+
+    /**
+     * Collect the pieces of a status line, header name or value.
+     * A token that runs up to the end of the buffer is not complete yet (its terminator was
+     * not seen), so it's moved to the carry-over buffer until the rest arrives.
+     *
+     * @returns True once the token is complete, with the token in view
+     */
+    bool collect(const char *at, uint32_t length, HttpStringView* view, bool* error) {
+        bool complete = at + length != _data + _length;
+
+        if (!_partial && complete) {
+            view->data = at;
+            view->length = length;
+            return true;
+        }
+
+        if (!_partial) {
+            _partial = true;
+            _partial_offset = _carry_length;
+            _partial_length = 0;
+        }
+
+        if (!append_to_carry(at, length)) {
+            *error = true;
+            return false;
+        }
+        _partial_length += length;
+
+        if (!complete) {
+            return false;
+        }
+
+        _partial = false;
+        view->data = _carry + _partial_offset;
+        view->length = _partial_length;
+        return true;
+    }
+
+    // the name is needed for the value (and folded values) but lives in a buffer that goes away
+    bool keep_name() {
+        if (!_has_name || _name_data == NULL) {
+            return true;
+        }
+
+        uint32_t offset = _carry_length;
+        if (!append_to_carry(_name_data, _name_length)) {
+            return false;
+        }
+        _name_data = NULL;
+        _name_offset = offset;
+        return true;
+    }
+
+    HttpStringView get_name() {
+        HttpStringView name = { _name_data ? _name_data : _carry + _name_offset, _name_length };
+        return name;
+    }
+
+    bool append_to_carry(const char *at, uint32_t length) {
+        if (_carry_length + length > _carry_capacity) {
+            uint32_t capacity = _carry_capacity ? _carry_capacity : HTTP_PULL_PARSER_CARRY_SIZE;
+            while (capacity < _carry_length + length) {
+                capacity *= 2;
+            }
+
+            char* carry = (char*)realloc(_carry, capacity);
+            if (carry == NULL) {
+                return false;
+            }
+            _carry = carry;
+            _carry_capacity = capacity;
+        }
+
+        memcpy(_carry + _carry_length, at, length);
+        _carry_length += length;
+        return true;
+    }
+
+    int on_status(const char *at, uint32_t length) {
+        HttpStringView reason;
+        bool error = false;
+        if (!collect(at, length, &reason, &error)) {
+            return error ? 1 : 0;
+        }
+
+        _status_reported = true;
+        HttpStringView none = { "", 0 };
+        push_event(HTTP_PULL_STATUS, none, reason);
+        return 0;
+    }
+
+    int on_header_field(const char *at, uint32_t length) {
+        report_status();
+
+        if (!_partial) {
+            // a new header, nothing in the carry-over buffer is needed anymore
+            _has_name = false;
+            _carry_length = 0;
+        }
+
+        HttpStringView name;
+        bool error = false;
+        if (!collect(at, length, &name, &error)) {
+            return error ? 1 : 0;
+        }
+
+        _has_name = true;
+        _name_length = name.length;
+        if (_carry != NULL && name.data >= _carry && name.data < _carry + _carry_length) {
+            _name_data = NULL;
+            _name_offset = name.data - _carry;
+        }
+        else {
+            _name_data = name.data;
+        }
+        return 0;
+    }
+
+    int on_header_value(const char *at, uint32_t length) {
+        // keep the name in front of the carried-over value, so the value can't move it out of the way
+        if (!_partial && at + length == _data + _length && !keep_name()) {
+            return 1;
+        }
+
+        HttpStringView value;
+        bool error = false;
+        if (!collect(at, length, &value, &error)) {
+            return error ? 1 : 0;
+        }
+
+        if (_has_name) {
+            push_event(HTTP_PULL_HEADER, get_name(), value);
+        }
+        return 0;
+    }
+
+    int on_headers_complete() {
+        report_status();
+
+        _has_name = false;
+        _carry_length = 0;
+        push_event(HTTP_PULL_HEADERS_COMPLETE);
+        return 0;
+    }
+
+    int on_body(const char *at, uint32_t length) {
+        HttpStringView none = { "", 0 };
+        HttpStringView body = { at, length };
+        push_event(HTTP_PULL_BODY, none, body);
+        return 0;
+    }
+
+    int on_message_complete() {
+        // trailers are done as well
+        _status_reported = false;
+        _has_name = false;
+        _carry_length = 0;
+        push_event(HTTP_PULL_MESSAGE_COMPLETE);
+        return 0;
+    }
+
+    // Static http_parser callback functions
+    static int on_status_callback(http_parser* parser, const char *at, uint32_t length) {
+        return ((HttpPullParser*)parser->data)->on_status(at, length);
+    }
+
+    static int on_header_field_callback(http_parser* parser, const char *at, uint32_t length) {
+        return ((HttpPullParser*)parser->data)->on_header_field(at, length);
+    }
+
+    static int on_header_value_callback(http_parser* parser, const char *at, uint32_t length) {
+        return ((HttpPullParser*)parser->data)->on_header_value(at, length);
+    }
+
+    static int on_headers_complete_callback(http_parser* parser) {
+        return ((HttpPullParser*)parser->data)->on_headers_complete();
+    }
+
+    static int on_body_callback(http_parser* parser, const char *at, uint32_t length) {
+        return ((HttpPullParser*)parser->data)->on_body(at, length);
+    }
+
+    static int on_message_complete_callback(http_parser* parser) {
+        return ((HttpPullParser*)parser->data)->on_message_complete();
+    }
+
+    http_parser _parser;
+    http_parser_settings _settings;
+
+    const char* _data;
+    uint32_t _length;
+    uint32_t _offset;
+    bool _finished;
+    bool _finish_done;
+
+    // a status line without reason phrase and the end of the headers arrive in the same callback
+    HttpPullEvent _events[2];
+    uint8_t _event_count;
+    uint8_t _event_next;
+    bool _status_reported;
+
+    // name of the current header, in the caller's buffer (_name_data) or in the carry-over buffer
+    bool _has_name;
+    const char* _name_data;
+    uint32_t _name_offset;
+    uint32_t _name_length;
+
+    // token that is split over two buffers, collected in the carry-over buffer
+    bool _partial;
+    uint32_t _partial_offset;
+    uint32_t _partial_length;
+
+    char* _carry;
+    uint32_t _carry_length;
+    uint32_t _carry_capacity;
+};
+
+#endif // _MBED_HTTP_PULL_PARSER_H_
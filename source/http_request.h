@@ -60,10 +60,8 @@ public:
         _parsed_url = new ParsedUrl(url);
         _request_builder = new HttpRequestBuilder(method, _parsed_url);
 
-        _socket = new TCPSocket();
-        ((TCPSocket*)_socket)->open(network);
-        network->gethostbyname(_parsed_url->host(), &address);
-        address.set_port(_parsed_url->port());
+        // socket is opened (or taken from the connection pool) when the request is sent
+        _network = network;
         _we_created_socket = true;
     }
 
@@ -96,6 +94,11 @@ public:
 
 protected:
 
+    virtual nsapi_error_t open_socket() {
+        _socket = new TCPSocket();
+        return ((TCPSocket*)_socket)->open(_network);
+    }
+
     virtual nsapi_error_t connect_socket(SocketAddress addr) {
         return ((TCPSocket*)_socket)->connect(addr);
     }
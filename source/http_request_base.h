@@ -23,10 +23,17 @@
 #include <vector>
 #include "mbed.h"
 #include "http_parser.h"
+#include "http_body_sink.h"
+#include "http_buffer_pool.h"
+#include "http_chunked_writer.h"
+#include "http_connection_pool.h"
+#include "http_deflater.h"
+#include "dns_cache.h"
 #include "http_parsed_url.h"
 #include "http_request_builder.h"
 #include "http_request_parser.h"
 #include "http_response.h"
+#include "http_response_cache.h"
 #include "NetworkInterface.h"
 #include "netsocket/Socket.h"
 
@@ -41,6 +48,7 @@
 
 class HttpRequest;
 class HttpsRequest;
+class HttpPipeline;
 
 /**
  * \brief HttpRequest implements the logic for interacting with HTTP servers.
@@ -48,16 +56,32 @@ class HttpsRequest;
 class HttpRequestBase {
     friend class HttpRequest;
     friend class HttpsRequest;
+    friend class HttpPipeline;
 
 public:
     HttpRequestBase(Socket *socket, Callback<void(const char *at, uint32_t length)> bodyCallback)
-        : _socket(socket), _body_callback(bodyCallback), _request_buffer(NULL), _request_buffer_ix(0)
-    {}
+        : _socket(socket), _body_callback(bodyCallback), _body_sink(NULL), _content_decoding(false),
+          _body_compression(false), _body_compression_format(HttpDeflater::DEFLATE_GZIP), _body_uncompressed_size(0),
+          _network(NULL), _connection_pool(NULL), _dns_cache(NULL), _response_cache(NULL),
+          _buffer_pool(NULL), _receive_buffer(NULL), _receive_buffer_size(0),
+          _request_buffer(NULL), _request_buffer_ix(0),
+          _async_queue(NULL), _async_state(ASYNC_IDLE), _async_request(NULL), _async_cancelled(false), _async_parser(NULL), _async_recv_buffer(NULL),
+          _async_step_event(0)
+    {
+        memset(&_chunked_stats, 0, sizeof(_chunked_stats));
+        core_util_atomic_flag_clear(&_async_step_pending);
+    }
 
     /**
      * HttpRequest Constructor
      */
     virtual ~HttpRequestBase() {
+        // a step that is still queued would run on a deleted request
+        cancel_async_step();
+        if (_async_state != ASYNC_IDLE && _async_state != ASYNC_DONE && _socket) {
+            _socket->sigio(NULL);
+        }
+
         // should response be owned by us? Or should user free it?
         // maybe implement copy constructor on response...
         if (_response) {
@@ -80,34 +104,24 @@ public:
     /**
      * Execute the request and receive the response.
      * This adds a Content-Length header to the request (when body_size is set), and sends the data to the server.
+     * With body compression on, the body is compressed and sent through chunked-encoding instead.
+     * With a response cache set, a GET request without a body may be answered from the cache.
      * @param body Pointer to the body to be sent
      * @param body_size Size of the body to be sent
      * @return An HttpResponse pointer on success, or NULL on failure.
      *         See get_error() for the error code.
      */
     HttpResponse* send(const void* body = NULL, nsapi_size_t body_size = 0) {
-        nsapi_size_or_error_t ret = connect_socket();
-
-        if (ret != NSAPI_ERROR_OK) {
-            _error = ret;
-            return NULL;
+        if (_body_compression && body_size > 0) {
+            // the compressed size is not known up front
+            return send_chunked(body, body_size, Callback<const void*(uint32_t*)>());
         }
 
-        _request_buffer_ix = 0;
-
-        uint32_t request_size = 0;
-        char* request = _request_builder->build(body, body_size, request_size);
-
-        ret = send_buffer(request, request_size);
-
-        free(request);
-
-        if (ret < 0) {
-            _error = ret;
-            return NULL;
+        if (_response_cache && body_size == 0 && is_cacheable_request()) {
+            return send_cached();
         }
 
-        return create_http_response();
+        return send_request(body, body_size);
     }
 
     /**
@@ -118,74 +132,7 @@ public:
      *         See get_error() for the error code.
      */
     HttpResponse* send(Callback<const void*(uint32_t*)> body_cb) {
-
-        nsapi_error_t ret;
-
-        if ((ret = connect_socket()) != NSAPI_ERROR_OK) {
-            _error = ret;
-            return NULL;
-        }
-
-        _request_buffer_ix = 0;
-
-        set_header("Transfer-Encoding", "chunked");
-
-        uint32_t request_size = 0;
-        char* request = _request_builder->build(NULL, 0, request_size);
-
-        // first... send this request headers without the body
-        nsapi_size_or_error_t total_send_count = send_buffer(request, request_size);
-
-        if (total_send_count < 0) {
-            free(request);
-            _error = total_send_count;
-            return NULL;
-        }
-
-        // ok... now it's time to start sending chunks...
-        while (1) {
-            uint32_t size;
-            const void *buffer = body_cb(&size);
-
-            if (size == 0) break;
-
-            // so... size in HEX, \r\n, data, \r\n again
-            char size_buff[10]; // if sending length of more than 8 digits, you have another problem on a microcontroller...
-            int size_buff_size = sprintf(size_buff, "%X\r\n", static_cast<size_t>(size));
-            if ((total_send_count = send_buffer(size_buff, static_cast<uint32_t>(size_buff_size))) < 0) {
-                free(request);
-                _error = total_send_count;
-                return NULL;
-            }
-
-            // now send the normal buffer... and then \r\n at the end
-            total_send_count = send_buffer((char*)buffer, size);
-            if (total_send_count < 0) {
-                free(request);
-                _error = total_send_count;
-                return NULL;
-            }
-
-            // and... \r\n
-            const char* rn = "\r\n";
-            if ((total_send_count = send_buffer((char*)rn, 2)) < 0) {
-                free(request);
-                _error = total_send_count;
-                return NULL;
-            }
-        }
-
-        // finalize...?
-        const char* fin = "0\r\n\r\n";
-        if ((total_send_count = send_buffer((char*)fin, strlen(fin))) < 0) {
-            free(request);
-            _error = total_send_count;
-            return NULL;
-        }
-
-        free(request);
-
-        return create_http_response();
+        return send_chunked(NULL, 0, body_cb);
     }
 
     /**
@@ -193,7 +140,8 @@ public:
      *
      * The 'Host', 'Content-Length', and (optionally) 'Transfer-Encoding: chunked'
      * headers are set automatically.
-     * Setting the same header twice will overwrite the previous entry.
+     * Setting the same header twice (keys are compared case-insensitive) will overwrite the previous entry.
+     * Headers are sent in the order they were first set.
      *
      * @param key Header key
      * @param value Header value
@@ -202,6 +150,10 @@ public:
         _request_builder->set_header(key, value);
     }
 
+    void set_header(const char* key, const char* value) {
+        _request_builder->set_header(key, value);
+    }
+
     /**
      * Get the error code.
      *
@@ -232,27 +184,487 @@ public:
         return _request_buffer_ix;
     }
 
+    /**
+     * Get statistics (chunks, bytes and socket writes) of the last chunked-encoding send.
+     */
+    ChunkedWriterStats get_chunked_stats() {
+        return _chunked_stats;
+    }
+
+    /**
+     * Use a connection pool for this request.
+     * Only applies to requests that were constructed with a NetworkInterface.
+     * An idle socket to the same host is taken from the pool (skipping DNS lookup and connect),
+     * and if the server allows keep-alive the socket is handed back to the pool after the response.
+     *
+     * @param pool The pool to use, needs to outlive the request
+     */
+    void set_connection_pool(ConnectionPool* pool) {
+        _connection_pool = pool;
+    }
+
+    /**
+     * Use a DNS cache for this request.
+     * Only applies to requests that were constructed with a NetworkInterface.
+     *
+     * @param cache The cache to use, needs to outlive the request
+     */
+    void set_dns_cache(DnsCache* cache) {
+        _dns_cache = cache;
+    }
+
+    /**
+     * Use a response cache for this request.
+     * Only send() of a GET request without a body uses the cache, and requests that set 'Range', 'If-None-Match'
+     * or 'If-Modified-Since' themselves bypass it. A response is only stored if its body was kept in the response
+     * (no body callback or body sink); cached bodies are passed to the body callback or sink like received ones.
+     *
+     * @param cache The cache to use, needs to outlive the request
+     */
+    void set_response_cache(ResponseCache* cache) {
+        _response_cache = cache;
+    }
+
+    /**
+     * Borrow the receive buffer from a buffer pool, instead of allocating it on the heap for every request.
+     * If the pool has no free buffer, the request falls back to allocating one.
+     *
+     * @param pool The pool to use, needs to outlive the request
+     */
+    void set_buffer_pool(BufferPool* pool) {
+        _buffer_pool = pool;
+    }
+
+    /**
+     * Receive into a buffer owned by the caller, instead of allocating one on the heap for every request.
+     * The buffer can be re-used by other requests, but only by one at a time.
+     *
+     * @param buffer The receive buffer, needs to outlive the request
+     * @param size Size of the buffer
+     */
+    void set_receive_buffer(void* buffer, uint32_t size) {
+        _receive_buffer = (uint8_t*)buffer;
+        _receive_buffer_size = size;
+    }
+
+    /**
+     * Ask for a compressed response (Accept-Encoding: gzip, deflate), and decompress gzip and deflate
+     * bodies while they're received. The response body, body callback and body sink all get the decompressed data.
+     * Needs HTTP_INFLATE_WINDOW_SIZE (32K) of extra heap while a compressed body is received.
+     * If the body is corrupt the request returns NULL, and get_error() returns -2102.
+     *
+     * @param enabled Whether to decompress
+     */
+    void set_content_decoding(bool enabled = true) {
+        _content_decoding = enabled;
+        if (enabled) {
+            set_header("Accept-Encoding", "gzip, deflate");
+        }
+    }
+
+    /**
+     * Set a callback that is called when the headers of the response are received, before the body.
+     * E.g. to check the status code and headers, and decide what to do with the body that follows.
+     *
+     * @param headers_cb Callback, gets the response (status and headers are set, the body is not)
+     */
+    void set_headers_callback(Callback<void(HttpResponse*)> headers_cb) {
+        _headers_callback = headers_cb;
+    }
+
+    /**
+     * Compress the request body (gzip, or zlib for 'deflate') while it is sent, and set the Content-Encoding header.
+     * The compressed size is not known up front, so the body is sent through chunked-encoding, also from send(body, body_size).
+     * Needs about 21K of extra heap while sending, set by HTTP_DEFLATE_WINDOW_SIZE, HTTP_DEFLATE_HASH_BITS,
+     * HTTP_DEFLATE_BLOCK_SYMBOLS and HTTP_DEFLATE_OUTPUT_SIZE. Does not apply to send_async() or pipelined requests.
+     * The server needs to accept compressed request bodies.
+     *
+     * @param enabled Whether to compress
+     * @param format DEFLATE_GZIP ('gzip') or DEFLATE_ZLIB ('deflate')
+     */
+    void set_body_compression(bool enabled = true, HttpDeflater::deflate_format format = HttpDeflater::DEFLATE_GZIP) {
+        _body_compression = enabled;
+        _body_compression_format = format;
+    }
+
+    /**
+     * Get the size of the last request body before compression (get_chunked_stats().payload_bytes is the size after).
+     */
+    uint32_t get_body_uncompressed_size() {
+        return _body_uncompressed_size;
+    }
+
+    /**
+     * Write the response body into a sink (file, block device, ring buffer, ...), instead of storing it
+     * in the response or passing it to the body callback. Data is handed to the sink straight from the receive buffer.
+     * If the sink fails, the request returns NULL and get_error() returns the sink's error.
+     *
+     * @param sink The sink to use, needs to outlive the request
+     */
+    void set_body_sink(BodySink* sink) {
+        _body_sink = sink;
+        _body_callback = callback(sink, &BodySink::on_body);
+    }
+
+    /**
+     * Execute the request without blocking the calling thread.
+     * The socket is put in non-blocking mode, and every time it signals activity the request
+     * makes as much progress as it can (connect, send headers, send body, receive) on the event queue.
+     * A single queue can drive many requests at the same time.
+     *
+     * Opening the socket and resolving the host name (unless cached) still happen in this call.
+     * Don't delete the request before the callback was called.
+     *
+     * @param queue Event queue on which the request is processed
+     * @param done_cb Called on the queue when the request finishes, with the response, or NULL on failure
+     *                (see get_error() for the error code)
+     * @param body Pointer to the body to be sent (copied, does not need to stay valid)
+     * @param body_size Size of the body to be sent
+     * @return NSAPI_ERROR_OK if the request was started, or an error code (callback will not be called)
+     */
+    nsapi_error_t send_async(EventQueue* queue, Callback<void(HttpResponse*)> done_cb,
+                             const void* body = NULL, nsapi_size_t body_size = 0) {
+        bool connected = false;
+        nsapi_error_t ret = open_socket_for_request(&connected);
+        if (ret != NSAPI_ERROR_OK) {
+            _error = ret;
+            return ret;
+        }
+
+        _request_buffer_ix = 0;
+
+        _async_queue = queue;
+        _async_done_cb = done_cb;
+        _async_request = _request_builder->build(body, body_size, _async_request_size);
+        _async_header_size = _async_request_size - body_size;
+        _async_offset = 0;
+        _async_first_connect = true;
+        _async_cancelled = false;
+        _async_state = connected ? ASYNC_SENDING_HEADERS : ASYNC_CONNECTING;
+
+        _socket->set_blocking(false);
+        _socket->sigio(callback(this, &HttpRequestBase::on_async_sigio));
+
+        // kick off, the socket might not signal before we try the first operation
+        if (!schedule_async_step()) {
+            _socket->sigio(NULL);
+            _socket->set_blocking(true);
+            free(_async_request);
+            _async_request = NULL;
+            _async_state = ASYNC_IDLE;
+            _error = NSAPI_ERROR_NO_MEMORY;
+            return NSAPI_ERROR_NO_MEMORY;
+        }
+        return NSAPI_ERROR_OK;
+    }
+
+    /**
+     * Stop a request that was started with send_async(), e.g. from its body callback once enough data came in.
+     * Call it on the queue that runs the request. The done callback is called with NULL, and get_error() returns -2104.
+     */
+    void cancel_async() {
+        if (_async_state == ASYNC_IDLE || _async_state == ASYNC_DONE) {
+            return;
+        }
+
+        // if the queue is full, the cancel is picked up by the step of the next socket event
+        _async_cancelled = true;
+        schedule_async_step();
+    }
+
 protected:
+    virtual nsapi_error_t open_socket() = 0;
     virtual nsapi_error_t connect_socket(SocketAddress addr) = 0;
 
 private:
     nsapi_error_t connect_socket( ) {
+        bool connected = false;
+        nsapi_error_t ret = open_socket_for_request(&connected);
+        if (ret != NSAPI_ERROR_OK || connected) {
+            return ret;
+        }
+
+        nsapi_error_t connection_result = connect_socket(address);
+        if (connection_result != NSAPI_ERROR_OK) {
+            if (_dns_cache) {
+                // the host might have moved, look it up again next time
+                _dns_cache->invalidate(_parsed_url->host());
+            }
+            return connection_result;
+        }
+
+        return NSAPI_ERROR_OK;
+    }
+
+    /**
+     * Get a socket for this request: takes one from the connection pool, or opens a new one and resolves the host.
+     * @param connected Set to true if the socket is already connected (pooled, or passed in by the user)
+     */
+    nsapi_error_t open_socket_for_request(bool* connected) {
         if (_response != NULL) {
             // already executed this response
             return -2100; // @todo, make a lookup table with errors
         }
 
 
-        if (_we_created_socket) {
-            nsapi_error_t connection_result = connect_socket(address);
-            if (connection_result != NSAPI_ERROR_OK) {
-                return connection_result;
+        if (!_we_created_socket) {
+            *connected = true;
+            return NSAPI_ERROR_OK;
+        }
+
+        if (_connection_pool) {
+            _socket = _connection_pool->acquire(_parsed_url->schema(), _parsed_url->host(), _parsed_url->port());
+            if (_socket) {
+                *connected = true;
+                return NSAPI_ERROR_OK;
             }
         }
 
+        nsapi_error_t open_result = open_socket();
+        if (open_result != NSAPI_ERROR_OK) {
+            return open_result;
+        }
+
+        nsapi_error_t dns_result;
+        if (_dns_cache) {
+            dns_result = _dns_cache->resolve(_network, _parsed_url->host(), &address);
+        }
+        else {
+            dns_result = _network->gethostbyname(_parsed_url->host(), &address);
+        }
+        if (dns_result != NSAPI_ERROR_OK) {
+            return dns_result;
+        }
+        address.set_port(_parsed_url->port());
+
+        *connected = false;
         return NSAPI_ERROR_OK;
     }
 
+    // Sends the headers and the body (straight from the caller's buffer), and receives the response
+    HttpResponse* send_request(const void* body, nsapi_size_t body_size) {
+        nsapi_size_or_error_t ret = connect_socket();
+
+        if (ret != NSAPI_ERROR_OK) {
+            _error = ret;
+            return NULL;
+        }
+
+        _request_buffer_ix = 0;
+
+        // only the headers are serialized, the body is sent straight from the caller's buffer
+        uint32_t request_size = 0;
+        char* request = _request_builder->build_headers(body_size, request_size);
+        if (!request) {
+            _error = NSAPI_ERROR_NO_MEMORY;
+            return NULL;
+        }
+
+        ret = send_buffer(request, request_size);
+
+        if (ret >= 0 && body_size > 0) {
+            ret = send_buffer((char*)body, body_size);
+        }
+
+        if (ret < 0) {
+            _error = ret;
+            return NULL;
+        }
+
+        return create_http_response();
+    }
+
+    // responses to requests with credentials are for that user only, the cache can be shared
+    bool is_cacheable_request() {
+        return _request_builder->get_method() == HTTP_GET
+            && !_request_builder->has_header("Authorization")
+            && !_request_builder->has_header("Range")
+            && !_request_builder->has_header("If-None-Match")
+            && !_request_builder->has_header("If-Modified-Since");
+    }
+
+    HttpResponse* send_cached() {
+        if (_response != NULL) {
+            // already executed this response
+            _error = -2100;
+            return NULL;
+        }
+
+        string key = cache_key();
+        bool fresh = false;
+        ResponseCacheEntry* entry = _response_cache->lookup(key.c_str(), &fresh);
+
+        if (entry && fresh) {
+            HttpResponse* res = respond_from_cache(entry);
+            delete entry;
+            return res;
+        }
+
+        if (entry) {
+            // stale, ask the server whether it's still good
+            HttpStringView etag = entry->get_header("etag");
+            if (etag.data) {
+                set_header("If-None-Match", etag.to_string());
+            }
+            HttpStringView last_modified = entry->get_header("last-modified");
+            if (last_modified.data) {
+                set_header("If-Modified-Since", last_modified.to_string());
+            }
+        }
+
+        HttpResponse* res = send_request(NULL, 0);
+
+        if (res && entry && res->get_status_code() == 304) {
+            _response_cache->revalidated(key.c_str(), entry, res);
+
+            delete _response;
+            _response = NULL;
+            res = respond_from_cache(entry);
+        }
+        else if (res && !_body_callback) {
+            _response_cache->store(key.c_str(), res);
+        }
+
+        delete entry;
+        return res;
+    }
+
+    HttpResponse* respond_from_cache(ResponseCacheEntry* entry) {
+        bool with_body = !_body_callback;
+        _response = entry->create_response(with_body);
+
+        if (_headers_callback) {
+            _headers_callback(_response);
+        }
+
+        if (!with_body) {
+            if (entry->get_body_length() > 0) {
+                _body_callback(entry->get_body(), entry->get_body_length());
+            }
+
+            nsapi_error_t ret = complete_body_sink();
+            if (ret != NSAPI_ERROR_OK) {
+                _error = ret;
+                return NULL;
+            }
+        }
+        return _response;
+    }
+
+    string cache_key() {
+        char port[8];
+        snprintf(port, sizeof(port), ":%u", _parsed_url->port());
+
+        string key = _parsed_url->schema();
+        key += "://";
+        key += _parsed_url->host();
+        key += port;
+        key += _parsed_url->path();
+        if (strlen(_parsed_url->query())) {
+            key += "?";
+            key += _parsed_url->query();
+        }
+
+        // the cache stores responses that vary on Accept-Encoding (only), so it is part of the key
+        string accept_encoding = _request_builder->get_header("Accept-Encoding");
+        if (!accept_encoding.empty()) {
+            key += " ";
+            key += accept_encoding;
+        }
+        return key;
+    }
+
+    /**
+     * Send the request through chunked-encoding (compressed if body compression is on), and receive the response.
+     * The body is either the buffer body/body_size, or (if body is NULL) the chunks generated by body_cb.
+     */
+    HttpResponse* send_chunked(const void* body, nsapi_size_t body_size, Callback<const void*(uint32_t*)> body_cb) {
+
+        nsapi_error_t ret;
+
+        if ((ret = connect_socket()) != NSAPI_ERROR_OK) {
+            _error = ret;
+            return NULL;
+        }
+
+        _request_buffer_ix = 0;
+
+        set_header("Transfer-Encoding", "chunked");
+        if (_body_compression) {
+            set_header("Content-Encoding", _body_compression_format == HttpDeflater::DEFLATE_GZIP ? "gzip" : "deflate");
+        }
+
+        uint32_t request_size = 0;
+        char* request = _request_builder->build_headers(0, request_size);
+        if (!request) {
+            _error = NSAPI_ERROR_NO_MEMORY;
+            return NULL;
+        }
+
+        // headers and chunk frames are coalesced in a staging buffer, so small chunks don't become tiny packets or TLS records
+        char* staging_buffer = (char*)malloc(HTTP_CHUNKED_BUFFER_SIZE);
+        if (!staging_buffer) {
+            _error = NSAPI_ERROR_NO_MEMORY;
+            return NULL;
+        }
+
+        ChunkedWriter writer(callback(this, &HttpRequestBase::send_buffer), staging_buffer, HTTP_CHUNKED_BUFFER_SIZE);
+
+        // the deflater hands its output buffer to the writer as a chunk whenever it fills up
+        HttpDeflater* deflater = NULL;
+        if (_body_compression) {
+            deflater = new HttpDeflater(_body_compression_format, callback(&writer, &ChunkedWriter::write_chunk));
+        }
+
+        // first... the request headers without the body
+        ret = writer.write_raw(request, request_size);
+
+        // ok... now it's time to start sending chunks...
+        if (body) {
+            if (ret >= 0) {
+                ret = write_body(&writer, deflater, body, body_size);
+            }
+        }
+        else {
+            while (ret >= 0) {
+                uint32_t size;
+                const void *buffer = body_cb(&size);
+
+                if (size == 0) break;
+
+                ret = write_body(&writer, deflater, buffer, size);
+            }
+        }
+
+        // finalize...
+        if (ret >= 0 && deflater) {
+            ret = deflater->finish();
+        }
+        if (ret >= 0) {
+            ret = writer.finish();
+        }
+
+        _chunked_stats = writer.get_stats();
+        _body_uncompressed_size = deflater ? deflater->get_uncompressed_bytes() : _chunked_stats.payload_bytes;
+
+        delete deflater;
+        free(staging_buffer);
+
+        if (ret < 0) {
+            _error = ret;
+            return NULL;
+        }
+
+        return create_http_response();
+    }
+
+    nsapi_size_or_error_t write_body(ChunkedWriter* writer, HttpDeflater* deflater, const void* data, uint32_t size) {
+        if (deflater) {
+            return deflater->write(data, size);
+        }
+        return writer->write_chunk(data, size);
+    }
+
     nsapi_size_or_error_t send_buffer(char* buffer, uint32_t buffer_size) {
         nsapi_size_or_error_t total_send_count = 0;
         while (total_send_count < buffer_size) {
@@ -286,25 +698,241 @@ private:
         return total_send_count;
     }
 
+    enum async_state {
+        ASYNC_IDLE,
+        ASYNC_CONNECTING,
+        ASYNC_SENDING_HEADERS,
+        ASYNC_SENDING_BODY,
+        ASYNC_RECEIVING,
+        ASYNC_DONE
+    };
+
+    // Called from the network stack context, so only defer to the queue here
+    void on_async_sigio() {
+        schedule_async_step();
+    }
+
+    // Returns false if the step could not be queued
+    bool schedule_async_step() {
+        // one pending step is enough, it handles everything that's available
+        if (core_util_atomic_flag_test_and_set(&_async_step_pending)) {
+            return true;
+        }
+
+        int id = _async_queue->call(this, &HttpRequestBase::async_step);
+        if (id == 0) {
+            // queue is full, let the next socket event try again
+            core_util_atomic_flag_clear(&_async_step_pending);
+            return false;
+        }
+        _async_step_event = id;
+        return true;
+    }
+
+    void cancel_async_step() {
+        int id = _async_step_event;
+        if (id != 0) {
+            _async_step_event = 0;
+            _async_queue->cancel(id);
+        }
+    }
+
+    void async_step() {
+        _async_step_event = 0;
+        core_util_atomic_flag_clear(&_async_step_pending);
+
+        while (_async_state != ASYNC_IDLE && _async_state != ASYNC_DONE) {
+            nsapi_size_or_error_t ret;
+
+            if (_async_cancelled) {
+                finish_async(-2104); // cancelled
+                return;
+            }
+
+            switch (_async_state) {
+                case ASYNC_CONNECTING:
+                    // the first call goes through the subclass (sets TLS hostname etc.), the rest continues the connect
+                    if (_async_first_connect) {
+                        _async_first_connect = false;
+                        ret = connect_socket(address);
+                    }
+                    else {
+                        ret = _socket->connect(address);
+                    }
+
+                    if (ret == NSAPI_ERROR_OK || ret == NSAPI_ERROR_IS_CONNECTED) {
+                        _async_state = ASYNC_SENDING_HEADERS;
+                        break;
+                    }
+                    if (ret == NSAPI_ERROR_WOULD_BLOCK || ret == NSAPI_ERROR_IN_PROGRESS || ret == NSAPI_ERROR_ALREADY) {
+                        return;
+                    }
+                    if (_dns_cache) {
+                        _dns_cache->invalidate(_parsed_url->host());
+                    }
+                    finish_async(ret);
+                    return;
+
+                case ASYNC_SENDING_HEADERS:
+                case ASYNC_SENDING_BODY:
+                    if (_async_offset == _async_request_size) {
+                        if (!start_async_receive()) {
+                            finish_async(NSAPI_ERROR_NO_MEMORY);
+                            return;
+                        }
+                        break;
+                    }
+
+                    ret = send_buffer_nonblocking(_async_request + _async_offset, _async_request_size - _async_offset);
+                    if (ret == NSAPI_ERROR_WOULD_BLOCK) {
+                        return;
+                    }
+                    if (ret < 0) {
+                        finish_async(ret);
+                        return;
+                    }
+
+                    _async_offset += ret;
+                    if (_async_offset >= _async_header_size) {
+                        _async_state = ASYNC_SENDING_BODY;
+                    }
+                    break;
+
+                case ASYNC_RECEIVING:
+                    ret = _socket->recv(_async_recv_buffer, _async_recv_buffer_size);
+                    if (ret == NSAPI_ERROR_WOULD_BLOCK) {
+                        return;
+                    }
+                    if (ret < 0) {
+                        finish_async(ret);
+                        return;
+                    }
+
+                    // connection closed by the server, finish() completes responses without Content-Length
+                    if (ret == 0) {
+                        _async_parser->finish();
+                        finish_async(NSAPI_ERROR_OK);
+                        return;
+                    }
+
+                    if (_async_parser->execute((const char*)_async_recv_buffer, ret) != (uint32_t)ret) {
+                        finish_async(-2101);
+                        return;
+                    }
+
+                    if (_response->is_message_complete()) {
+                        _async_parser->finish();
+                        finish_async(NSAPI_ERROR_OK);
+                        return;
+                    }
+                    break;
+
+                default:
+                    return;
+            }
+        }
+    }
+
+    bool start_async_receive() {
+        free(_async_request);
+        _async_request = NULL;
+
+        _response = new HttpResponse();
+        _async_parser = new HttpParser(_response, HTTP_RESPONSE, _body_callback);
+        _async_parser->setContentDecoding(_content_decoding);
+        _async_parser->setSkipBody(_request_builder->get_method() == HTTP_HEAD);
+        _async_parser->setHeaderCompleteCallBack(_headers_callback);
+        _async_recv_buffer = acquire_receive_buffer(&_async_recv_buffer_size);
+        _async_state = ASYNC_RECEIVING;
+
+        return _async_recv_buffer != NULL;
+    }
+
+    void finish_async(nsapi_error_t result) {
+        _async_state = ASYNC_DONE;
+
+        _socket->sigio(NULL);
+        _socket->set_blocking(true);
+
+        // a step queued by a socket event or by cancel_async() must not run after the done callback
+        cancel_async_step();
+
+        bool keep_alive = result == NSAPI_ERROR_OK && _response->is_message_complete() && _async_parser->should_keep_alive();
+
+        if (result == NSAPI_ERROR_OK && _async_parser) {
+            result = _async_parser->getContentDecodingError();
+        }
+        if (result == NSAPI_ERROR_OK) {
+            result = _response->get_body_error();
+        }
+
+        if (_async_request) {
+            free(_async_request);
+            _async_request = NULL;
+        }
+        if (_async_recv_buffer) {
+            release_receive_buffer(_async_recv_buffer);
+            _async_recv_buffer = NULL;
+        }
+        if (_async_parser) {
+            delete _async_parser;
+            _async_parser = NULL;
+        }
+
+        if (result == NSAPI_ERROR_OK) {
+            result = complete_body_sink();
+        }
+
+        if (result != NSAPI_ERROR_OK) {
+            _error = result;
+            release_socket(false);
+            _async_done_cb(NULL);
+            return;
+        }
+
+        release_socket(keep_alive);
+        _async_done_cb(_response);
+    }
+
+    // Sends as much as the socket accepts without blocking, logs it in the request log buffer
+    nsapi_size_or_error_t send_buffer_nonblocking(char* buffer, uint32_t buffer_size) {
+        nsapi_size_or_error_t send_result = _socket->send(buffer, buffer_size);
+
+        if (send_result > 0 && _request_buffer != NULL && _request_buffer_ix + send_result < _request_buffer_size) {
+            memcpy(_request_buffer + _request_buffer_ix, buffer, send_result);
+            _request_buffer_ix += send_result;
+        }
+
+        return send_result;
+    }
+
     HttpResponse* create_http_response() {
         // Create a response object
         _response = new HttpResponse();
         // And a response parser
         HttpParser parser(_response, HTTP_RESPONSE, _body_callback);
-
-        // Set up a receive buffer (on the heap)
-        uint8_t* recv_buffer = (uint8_t*)malloc(HTTP_RECEIVE_BUFFER_SIZE);
+        parser.setContentDecoding(_content_decoding);
+        parser.setSkipBody(_request_builder->get_method() == HTTP_HEAD);
+        parser.setHeaderCompleteCallBack(_headers_callback);
+
+        // Set up a receive buffer (from the pool, the caller or the heap)
+        uint32_t recv_buffer_size;
+        uint8_t* recv_buffer = acquire_receive_buffer(&recv_buffer_size);
+        if (!recv_buffer) {
+            _error = NSAPI_ERROR_NO_MEMORY;
+            return NULL;
+        }
 
         // Socket::recv is called until we don't have any data anymore
         nsapi_size_or_error_t recv_ret;
-        while ((recv_ret = _socket->recv(recv_buffer, HTTP_RECEIVE_BUFFER_SIZE)) > 0) {
+        while ((recv_ret = _socket->recv(recv_buffer, recv_buffer_size)) > 0) {
 
             // Pass the chunk into the http_parser
             uint32_t nparsed = parser.execute((const char*)recv_buffer, recv_ret);
             if (nparsed != recv_ret) {
                 // printf("Parsing failed... parsed %d bytes, received %d bytes\n", nparsed, recv_ret);
                 _error = -2101;
-                free(recv_buffer);
+                release_receive_buffer(recv_buffer);
                 return NULL;
             }
 
@@ -315,29 +943,104 @@ private:
         // error?
         if (recv_ret < 0) {
             _error = recv_ret;
-            free(recv_buffer);
+            release_receive_buffer(recv_buffer);
             return NULL;
         }
 
         // When done, call parser.finish()
         parser.finish();
 
-        // Free the receive buffer
-        free(recv_buffer);
+        // Hand back the receive buffer
+        release_receive_buffer(recv_buffer);
 
-        if (_we_created_socket) {
-            // Close the socket
-            _socket->close();
+        nsapi_error_t body_ret = parser.getContentDecodingError();
+        if (body_ret == NSAPI_ERROR_OK) {
+            body_ret = _response->get_body_error();
+        }
+        if (body_ret == NSAPI_ERROR_OK) {
+            body_ret = complete_body_sink();
+        }
+        if (body_ret != NSAPI_ERROR_OK) {
+            _error = body_ret;
+            release_socket(false);
+            return NULL;
         }
 
+        release_socket(_response->is_message_complete() && parser.should_keep_alive());
+
         return _response;
     }
 
+    uint8_t* acquire_receive_buffer(uint32_t* size) {
+        if (_receive_buffer) {
+            *size = _receive_buffer_size;
+            return _receive_buffer;
+        }
+
+        if (_buffer_pool) {
+            uint8_t* buffer = (uint8_t*)_buffer_pool->acquire(HTTP_RECEIVE_BUFFER_SIZE, size);
+            if (buffer) {
+                return buffer;
+            }
+        }
+
+        *size = HTTP_RECEIVE_BUFFER_SIZE;
+        return (uint8_t*)malloc(HTTP_RECEIVE_BUFFER_SIZE);
+    }
+
+    void release_receive_buffer(uint8_t* buffer) {
+        if (buffer == _receive_buffer) {
+            return;
+        }
+        if (_buffer_pool && _buffer_pool->release(buffer)) {
+            return;
+        }
+        free(buffer);
+    }
+
+    nsapi_error_t complete_body_sink() {
+        if (!_body_sink) {
+            return NSAPI_ERROR_OK;
+        }
+        return _body_sink->complete();
+    }
+
+    void release_socket(bool keep_alive) {
+        if (!_we_created_socket) {
+            return;
+        }
+
+        if (_connection_pool && keep_alive) {
+            // Hand the socket over to the pool, it now owns it
+            _connection_pool->release(_parsed_url->schema(), _parsed_url->host(), _parsed_url->port(), _socket);
+            _socket = NULL;
+        }
+        else {
+            // Close the socket
+            _socket->close();
+        }
+    }
+
 private:
     Socket* _socket;
     Callback<void(const char *at, uint32_t length)> _body_callback;
+    Callback<void(HttpResponse*)> _headers_callback;
+    BodySink* _body_sink;
+    bool _content_decoding;
+    bool _body_compression;
+    HttpDeflater::deflate_format _body_compression_format;
+    uint32_t _body_uncompressed_size;
     SocketAddress address;
 
+    NetworkInterface* _network;
+    ConnectionPool* _connection_pool;
+    DnsCache* _dns_cache;
+    ResponseCache* _response_cache;
+    BufferPool* _buffer_pool;
+
+    uint8_t* _receive_buffer;
+    uint32_t _receive_buffer_size;
+
     ParsedUrl* _parsed_url;
 
     HttpRequestBuilder* _request_builder;
@@ -350,6 +1053,23 @@ private:
     uint8_t *_request_buffer;
     size_t _request_buffer_size;
     size_t _request_buffer_ix;
+
+    ChunkedWriterStats _chunked_stats;
+
+    EventQueue* _async_queue;
+    Callback<void(HttpResponse*)> _async_done_cb;
+    async_state _async_state;
+    core_util_atomic_flag _async_step_pending;
+    char* _async_request;
+    uint32_t _async_request_size;
+    uint32_t _async_header_size;
+    uint32_t _async_offset;
+    bool _async_first_connect;
+    bool _async_cancelled;
+    HttpParser* _async_parser;
+    uint8_t* _async_recv_buffer;
+    uint32_t _async_recv_buffer_size;
+    volatile int _async_step_event;
 };
 
 #endif // _HTTP_REQUEST_BASE_H_
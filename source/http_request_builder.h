@@ -19,54 +19,192 @@
 #define _MBED_HTTP_REQUEST_BUILDER_H_
 
 #include <string>
-#include <map>
 #include "http_parser.h"
 #include "http_parsed_url.h"
 
+#ifndef HTTP_REQUEST_HEADERS_INITIAL_SIZE
+#define HTTP_REQUEST_HEADERS_INITIAL_SIZE 128
+#endif
+
 class HttpRequestBuilder {
 public:
     HttpRequestBuilder(http_method a_method, ParsedUrl* a_parsed_url)
-        : method(a_method), parsed_url(a_parsed_url)
+        : method(a_method), parsed_url(a_parsed_url), headers(NULL), headers_length(0), headers_capacity(0),
+          header_buffer(NULL), header_buffer_size(0)
     {
-        string host(parsed_url->host());
-
-        char port_str[10];
-        sprintf(port_str, ":%d", parsed_url->port());
+        char host[256];
+        bool default_port = true;
 
         if (strcmp(parsed_url->schema(), "http") == 0 && parsed_url->port() != 80) {
-            host += string(port_str);
+            default_port = false;
         }
         else if (strcmp(parsed_url->schema(), "https") == 0 && parsed_url->port() != 443) {
-            host += string(port_str);
+            default_port = false;
         }
         else if (strcmp(parsed_url->schema(), "ws") == 0 && parsed_url->port() != 80) {
-            host += string(port_str);
+            default_port = false;
         }
         else if (strcmp(parsed_url->schema(), "wss") == 0 && parsed_url->port() != 443) {
-            host += string(port_str);
+            default_port = false;
+        }
+
+        if (default_port) {
+            snprintf(host, sizeof(host), "%s", parsed_url->host());
+        }
+        else {
+            snprintf(host, sizeof(host), "%s:%d", parsed_url->host(), parsed_url->port());
         }
 
         set_header("Host", host);
     }
 
+    ~HttpRequestBuilder() {
+        if (headers) {
+            free(headers);
+        }
+        if (header_buffer) {
+            free(header_buffer);
+        }
+    }
+
     /**
      * Set a header for the request
-     * If the key already exists, it will be overwritten...
+     * If the key already exists (compared case-insensitive), it will be overwritten...
      */
     void set_header(string key, string value) {
-        map<string, string>::iterator it = headers.find(key);
+        set_header(key.c_str(), value.c_str());
+    }
 
-        if (it != headers.end()) {
-            it->second = value;
+    void set_header(const char* key, const char* value) {
+        size_t key_len = strlen(key);
+        size_t value_len = strlen(value);
+
+        // line is KEY: VALUE\r\n
+        uint32_t new_line_len = key_len + 2 + value_len + 2;
+
+        uint32_t line_start, line_len;
+        if (find_header(key, key_len, &line_start, &line_len)) {
+            // replace in place, so the header keeps its position
+            if (!reserve(headers_length - line_len + new_line_len)) {
+                return;
+            }
+            memmove(headers + line_start + new_line_len, headers + line_start + line_len,
+                    headers_length - line_start - line_len);
+            headers_length = headers_length - line_len + new_line_len;
         }
         else {
-            headers.insert(headers.end(), pair<string, string>(key, value));
+            if (!reserve(headers_length + new_line_len)) {
+                return;
+            }
+            line_start = headers_length;
+            headers_length += new_line_len;
         }
+
+        char* line = headers + line_start;
+        memcpy(line, key, key_len);
+        line += key_len;
+        memcpy(line, ": ", 2);
+        line += 2;
+        memcpy(line, value, value_len);
+        line += value_len;
+        memcpy(line, "\r\n", 2);
     }
 
     char* build(const void* body, uint32_t body_size, uint32_t &size, bool skip_content_length = false) {
-        const char* method_str = http_method_str(method);
+        bool is_chunked = prepare_headers(body_size);
+
+        size = headers_size();
+
+        if (!is_chunked) {
+            // body
+            size += body_size;
+        }
+
+        // Now let's print it
+        char* req = (char*)calloc(size + 1, 1);
+        char* originalReq = req;
+
+        req += write_headers(req);
 
+        if (body_size > 0) {
+            memcpy(req, body, body_size);
+        }
+        req += body_size;
+
+        // Uncomment to debug...
+        // printf("----- BEGIN REQUEST -----\n");
+        // printf("%s", originalReq);
+        // printf("----- END REQUEST -----\n");
+
+        return originalReq;
+    }
+
+    /**
+     * Serialize only the request line and headers (including the empty line that ends them),
+     * the body is not copied and can be sent directly after it.
+     * The returned buffer is owned by the builder and re-used by the next call, don't free it.
+     */
+    char* build_headers(uint32_t body_size, uint32_t &size) {
+        prepare_headers(body_size);
+
+        size = headers_size();
+
+        if (size + 1 > header_buffer_size) {
+            char* new_buffer = (char*)realloc(header_buffer, size + 1);
+            if (!new_buffer) {
+                size = 0;
+                return NULL;
+            }
+            header_buffer = new_buffer;
+            header_buffer_size = size + 1;
+        }
+
+        write_headers(header_buffer);
+
+        return header_buffer;
+    }
+
+    http_method get_method() {
+        return method;
+    }
+
+    /**
+     * Whether a header was set (key is compared case-insensitive), optionally with a certain value.
+     */
+    bool has_header(const char* key, const char* value = NULL) {
+        uint32_t line_start, line_len;
+        size_t key_len = strlen(key);
+
+        if (!find_header(key, key_len, &line_start, &line_len)) {
+            return false;
+        }
+
+        if (value == NULL) {
+            return true;
+        }
+
+        // value sits between "KEY: " and "\r\n"
+        size_t value_len = strlen(value);
+        return line_len - key_len - 4 == value_len &&
+               memcmp(headers + line_start + key_len + 2, value, value_len) == 0;
+    }
+
+    /**
+     * Value of a header (key is compared case-insensitive), empty if not set.
+     */
+    string get_header(const char* key) {
+        uint32_t line_start, line_len;
+        size_t key_len = strlen(key);
+
+        if (!find_header(key, key_len, &line_start, &line_len)) {
+            return string();
+        }
+        return string(headers + line_start + key_len + 2, line_len - key_len - 4);
+    }
+
+private:
+    // sets Content-Length when needed, returns whether the request is chunked
+    bool prepare_headers(uint32_t body_size) {
         bool is_chunked = has_header("Transfer-Encoding", "chunked");
 
         if (!is_chunked && (method == HTTP_POST || method == HTTP_PUT || method == HTTP_DELETE || body_size > 0)) {
@@ -75,28 +213,31 @@ public:
             set_header("Content-Length", string(buffer));
         }
 
-        size = 0;
+        return is_chunked;
+    }
+
+    uint32_t request_line_size() {
+        const char* method_str = http_method_str(method);
 
         // first line is METHOD PATH+QUERY HTTP/1.1\r\n
-        size += strlen(method_str) + 1 + strlen(parsed_url->path()) + (strlen(parsed_url->query()) ? strlen(parsed_url->query()) + 1 : 0) + 1 + 8 + 2;
+        return strlen(method_str) + 1 + strlen(parsed_url->path()) + (strlen(parsed_url->query()) ? strlen(parsed_url->query()) + 1 : 0) + 1 + 8 + 2;
+    }
 
-        // after that we'll do the headers
-        typedef map<string, string>::iterator it_type;
-        for(it_type it = headers.begin(); it != headers.end(); it++) {
-            // line is KEY: VALUE\r\n
-            size += it->first.length() + 1 + 1 + it->second.length() + 2;
-        }
+    uint32_t headers_size() {
+        uint32_t size = request_line_size();
+
+        // after that we'll do the headers, already serialized
+        size += headers_length;
 
-        // then the body, first an extra newline
+        // then an extra newline before the body
         size += 2;
 
-        if (!is_chunked) {
-            // body
-            size += body_size;
-        }
+        return size;
+    }
 
-        // Now let's print it
-        char* req = (char*)calloc(size + 1, 1);
+    // writes request line and headers to req (which has room for headers_size() + 1 bytes), returns bytes written
+    uint32_t write_headers(char* req) {
+        const char* method_str = http_method_str(method);
         char* originalReq = req;
 
         if (strlen(parsed_url->query())) {
@@ -104,48 +245,75 @@ public:
         } else {
             sprintf(req, "%s %s%s HTTP/1.1\r\n", method_str, parsed_url->path(), parsed_url->query());
         }
-        req += strlen(method_str) + 1 + strlen(parsed_url->path()) + (strlen(parsed_url->query()) ? strlen(parsed_url->query()) + 1 : 0) + 1 + 8 + 2;
+        req += request_line_size();
 
-        typedef map<string, string>::iterator it_type;
-        for(it_type it = headers.begin(); it != headers.end(); it++) {
-            // line is KEY: VALUE\r\n
-            sprintf(req, "%s: %s\r\n", it->first.c_str(), it->second.c_str());
-            req += it->first.length() + 1 + 1 + it->second.length() + 2;
-        }
+        memcpy(req, headers, headers_length);
+        req += headers_length;
 
         sprintf(req, "\r\n");
         req += 2;
 
-        if (body_size > 0) {
-            memcpy(req, body, body_size);
-        }
-        req += body_size;
+        return req - originalReq;
+    }
 
-        // Uncomment to debug...
-        // printf("----- BEGIN REQUEST -----\n");
-        // printf("%s", originalReq);
-        // printf("----- END REQUEST -----\n");
+    // finds the line of a header (case-insensitive key), returns false if not set
+    bool find_header(const char* key, size_t key_len, uint32_t* line_start, uint32_t* line_len) {
+        uint32_t ix = 0;
+        while (ix < headers_length) {
+            const char* line = headers + ix;
+            const char* line_end = (const char*)memchr(line, '\n', headers_length - ix) + 1;
 
-        return originalReq;
+            if (line_end - line > (int)key_len && line[key_len] == ':' && key_equals(line, key, key_len)) {
+                *line_start = ix;
+                *line_len = line_end - line;
+                return true;
+            }
+
+            ix += line_end - line;
+        }
+        return false;
     }
 
-private:
-    bool has_header(const char* key, const char* value = NULL) {
-        typedef map<string, string>::iterator it_type;
-        for(it_type it = headers.begin(); it != headers.end(); it++) {
-            if (strcmp(it->first.c_str(), key) == 0) { // key matches
-                if (value == NULL || (strcmp(it->second.c_str(), value) == 0)) { // value is NULL or matches
-                    return true;
-                }
-            }
+    static bool key_equals(const char* a, const char* b, size_t len) {
+        for (size_t ix = 0; ix < len; ix++) {
+            char ca = a[ix], cb = b[ix];
+            if (ca >= 'A' && ca <= 'Z') ca += 'a' - 'A';
+            if (cb >= 'A' && cb <= 'Z') cb += 'a' - 'A';
+            if (ca != cb) return false;
         }
+        return true;
+    }
 
-        return false;
+    // make sure the header arena can hold size bytes, grows geometrically
+    bool reserve(uint32_t size) {
+        if (size <= headers_capacity) {
+            return true;
+        }
+
+        uint32_t capacity = headers_capacity ? headers_capacity : HTTP_REQUEST_HEADERS_INITIAL_SIZE;
+        while (capacity < size) {
+            capacity *= 2;
+        }
+
+        char* new_headers = (char*)realloc(headers, capacity);
+        if (!new_headers) {
+            return false;
+        }
+        headers = new_headers;
+        headers_capacity = capacity;
+        return true;
     }
 
     http_method method;
     ParsedUrl* parsed_url;
-    map<string, string> headers;
+
+    // all headers as "KEY: VALUE\r\n" lines, in the order they were set
+    char* headers;
+    uint32_t headers_length;
+    uint32_t headers_capacity;
+
+    char* header_buffer;
+    uint32_t header_buffer_size;
 };
 
 #endif // _MBED_HTTP_REQUEST_BUILDER_H_
@@ -0,0 +1,156 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MBED_HTTP_REQUEST_MULTIPLEXER_H_
+#define _MBED_HTTP_REQUEST_MULTIPLEXER_H_
+
+#include <vector>
+#include "mbed.h"
+#include "http_request_base.h"
+
+#ifndef HTTP_MULTIPLEXER_MAX_CONCURRENT
+#define HTTP_MULTIPLEXER_MAX_CONCURRENT 8
+#endif
+
+using namespace std;
+
+/**
+ * \brief RequestMultiplexer drives many requests concurrently from a single thread.
+ *
+ * Requests are added up front, and started (through send_async()) as long as fewer than
+ * max_concurrent are in flight. Every socket's data is fed into its own request's parser
+ * as it arrives, and each request reports completion through its own callback.
+ */
+class RequestMultiplexer {
+public:
+    /**
+     * RequestMultiplexer Constructor
+     *
+     * @param[in] queue Event queue on which all requests are processed
+     * @param[in] max_concurrent Maximum number of requests in flight at the same time
+     */
+    RequestMultiplexer(EventQueue* queue, uint32_t max_concurrent = HTTP_MULTIPLEXER_MAX_CONCURRENT)
+        : _queue(queue), _max_concurrent(max_concurrent), _next(0), _active(0), _completed(0), _running(false)
+    {}
+
+    ~RequestMultiplexer() {
+        for (size_t ix = 0; ix < _items.size(); ix++) {
+            delete _items[ix];
+        }
+    }
+
+    /**
+     * Add a request. Requests are started in the order they were added.
+     * Add all requests before calling run().
+     *
+     * @param request The request, needs to stay alive until its callback was called
+     * @param done_cb Called with the request and its response (or NULL on failure, see request->get_error())
+     * @param body Pointer to the body to be sent, needs to stay valid until the request was started
+     * @param body_size Size of the body to be sent
+     */
+    void add(HttpRequestBase* request, Callback<void(HttpRequestBase*, HttpResponse*)> done_cb,
+             const void* body = NULL, nsapi_size_t body_size = 0) {
+        Item* item = new Item();
+        item->multiplexer = this;
+        item->request = request;
+        item->done_cb = done_cb;
+        item->body = body;
+        item->body_size = body_size;
+        _items.push_back(item);
+    }
+
+    /**
+     * Run all requests that were added, and dispatch the queue until all of them finished.
+     * Blocks the calling thread, which becomes the thread that drives all requests.
+     */
+    void run() {
+        if (_next == _items.size() && _active == 0) {
+            return;
+        }
+
+        _running = true;
+        _queue->call(this, &RequestMultiplexer::start_next);
+        _queue->dispatch_forever();
+        _running = false;
+    }
+
+    /**
+     * Number of requests currently in flight.
+     */
+    uint32_t get_active() {
+        return _active;
+    }
+
+    /**
+     * Number of requests that finished (successfully or not).
+     */
+    uint32_t get_completed() {
+        return _completed;
+    }
+
+private:
+    struct Item {
+        RequestMultiplexer* multiplexer;
+        HttpRequestBase* request;
+        Callback<void(HttpRequestBase*, HttpResponse*)> done_cb;
+        const void* body;
+        nsapi_size_t body_size;
+
+        void on_done(HttpResponse* response) {
+            multiplexer->on_request_done(this, response);
+        }
+    };
+
+    void start_next() {
+        while (_active < _max_concurrent && _next < _items.size()) {
+            Item* item = _items[_next++];
+
+            nsapi_error_t ret = item->request->send_async(_queue, callback(item, &Item::on_done), item->body, item->body_size);
+            if (ret == NSAPI_ERROR_OK) {
+                _active++;
+            }
+            else {
+                // failed before anything was sent, the request's error is already set
+                _completed++;
+                item->done_cb(item->request, NULL);
+            }
+        }
+
+        if (_active == 0 && _next == _items.size() && _running) {
+            _queue->break_dispatch();
+        }
+    }
+
+    void on_request_done(Item* item, HttpResponse* response) {
+        _active--;
+        _completed++;
+        item->done_cb(item->request, response);
+
+        start_next();
+    }
+
+    EventQueue* _queue;
+    uint32_t _max_concurrent;
+
+    vector<Item*> _items;
+    size_t _next;
+    uint32_t _active;
+    uint32_t _completed;
+    bool _running;
+};
+
+#endif // _MBED_HTTP_REQUEST_MULTIPLEXER_H_
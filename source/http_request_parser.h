@@ -20,12 +20,14 @@
 
 #include "http_parser.h"
 #include "http_response.h"
+#include "http_inflater.h"
 
 class HttpParser {
 public:
 
     HttpParser(HttpResponse* a_response, http_parser_type parser_type, Callback<void(const char *at, uint32_t length)> a_body_callback = 0)
-        : response(a_response), body_callback(a_body_callback)
+        : response(a_response), body_callback(a_body_callback), content_decoding(false), inflater(NULL),
+          decoding_error(NSAPI_ERROR_OK), skip_body(false)
     {
         settings = new http_parser_settings();
 
@@ -54,7 +56,35 @@ public:
       this->body_callback = a_body_callback;
     }
 
+    void setMessageCompleteCallBack(Callback<void(HttpResponse* response)> a_messagecomplete_callback) {
+      this->messagecomplete_callback = a_messagecomplete_callback;
+    }
+
+    // Switch to another response object, e.g. from the message complete callback when
+    // parsing several (pipelined) responses from the same connection
+    void setResponse(HttpResponse* a_response) {
+      this->response = a_response;
+    }
+
+    // Decode gzip and deflate response bodies (Content-Encoding) before they're passed on
+    void setContentDecoding(bool a_content_decoding) {
+      this->content_decoding = a_content_decoding;
+    }
+
+    // The response to a HEAD request has no body, even though it can have a Content-Length or be chunked
+    void setSkipBody(bool a_skip_body) {
+      this->skip_body = a_skip_body;
+    }
+
+    // Error of the content decoder (e.g. corrupt gzip data) for the last message, NSAPI_ERROR_OK if none
+    nsapi_error_t getContentDecodingError() {
+      return decoding_error;
+    }
+
     ~HttpParser() {
+        if (inflater) {
+            delete inflater;
+        }
         if (parser) {
             delete parser;
         }
@@ -71,6 +101,14 @@ public:
         http_parser_execute(parser, settings, NULL, 0);
     }
 
+    /**
+     * Whether the connection can be re-used after the current message.
+     * Only meaningful after the message is complete.
+     */
+    bool should_keep_alive() {
+        return http_should_keep_alive(parser) != 0;
+    }
+
 private:
     // Member functions
     int on_message_begin(http_parser* parser) {
@@ -84,48 +122,100 @@ private:
     }
 
     int on_status(http_parser* parser, const char *at, uint32_t length) {
-        string s(at, length);
-        response->set_status(parser->status_code, s);
+        response->set_status(parser->status_code, at, length);
         return 0;
     }
 
     int on_header_field(http_parser* parser, const char *at, uint32_t length) {
-        string s(at, length);
-        response->set_header_field(s);
+        response->set_header_field(at, length);
         return 0;
     }
 
     int on_header_value(http_parser* parser, const char *at, uint32_t length) {
-        string s(at, length);
-        response->set_header_value(s);
+        response->set_header_value(at, length);
         return 0;
     }
 
     int on_headers_complete(http_parser* parser) {
         response->set_headers_complete();
         response->set_method((http_method)parser->method);
+
+        decoding_error = NSAPI_ERROR_OK;
+        if (content_decoding) {
+            start_content_decoding();
+        }
       
         if(headercomplete_callback) {
           headercomplete_callback(response);
         }
-        return 0;
+
+        // 1 tells http_parser that the message has no body
+        return skip_body ? 1 : 0;
     }
 
     int on_body(http_parser* parser, const char *at, uint32_t length) {
         response->increase_body_length(length);
 
+        if (inflater) {
+            // decoded data comes back through on_decoded_body. A corrupt body does not stop the parser,
+            // the rest of the message is still consumed so the connection stays usable.
+            if (decoding_error == NSAPI_ERROR_OK) {
+                decoding_error = inflater->write(at, length);
+            }
+            return 0;
+        }
+
+        on_decoded_body(at, length);
+        return 0;
+    }
+
+    void on_decoded_body(const char *at, uint32_t length) {
+        response->increase_body_decoded_length(length);
+
         if (body_callback) {
             body_callback(at, length);
-            return 0;
+            return;
         }
 
         response->set_body(at, length);
-        return 0;
+    }
+
+    void start_content_decoding() {
+        HttpStringView encoding = response->get_header(HTTP_HEADER_CONTENT_ENCODING);
+        if (!encoding.data) {
+            return;
+        }
+
+        if (encoding.iequals("gzip") || encoding.iequals("x-gzip")) {
+            inflater = new HttpInflater(HttpInflater::INFLATE_GZIP, callback(this, &HttpParser::on_decoded_body));
+        }
+        else if (encoding.iequals("deflate")) {
+            inflater = new HttpInflater(HttpInflater::INFLATE_DEFLATE, callback(this, &HttpParser::on_decoded_body));
+        }
+        else {
+            // unknown encoding, passed on as-is
+            return;
+        }
+
+        response->set_content_decoded();
     }
 
     int on_message_complete(http_parser* parser) {
+        if (inflater) {
+            // responses without a body (e.g. HEAD) have nothing to decode
+            if (decoding_error == NSAPI_ERROR_OK && inflater->get_compressed_bytes() > 0) {
+                decoding_error = inflater->finish();
+            }
+            delete inflater;
+            inflater = NULL;
+        }
+
         response->set_message_complete();
 
+        if (messagecomplete_callback) {
+            messagecomplete_callback(response);
+        }
+
         return 0;
     }
 
@@ -183,6 +273,11 @@ private:
     HttpResponse* response;
     Callback<void(const char *at, uint32_t length)> body_callback;
     Callback<void(HttpResponse* response)> headercomplete_callback;
+    Callback<void(HttpResponse* response)> messagecomplete_callback;
+    bool content_decoding;
+    HttpInflater* inflater;
+    nsapi_error_t decoding_error;
+    bool skip_body;
     http_parser* parser;
     http_parser_settings* settings;
 };
@@ -20,21 +20,75 @@
 #include <string>
 #include <vector>
 #include "http_parser.h"
+#include "http_known_header.h"
 
 using namespace std;
 
+#ifndef HTTP_RESPONSE_BODY_INITIAL_SIZE
+#define HTTP_RESPONSE_BODY_INITIAL_SIZE 1024
+#endif
+
+#ifndef HTTP_RESPONSE_HEADERS_INITIAL_SIZE
+#define HTTP_RESPONSE_HEADERS_INITIAL_SIZE 512
+#endif
+
+/**
+ * Non-owning view on a string inside an HttpResponse, not NULL terminated.
+ */
+struct HttpStringView {
+    const char* data;
+    uint32_t length;
+
+    bool equals(const char* other) const {
+        return strlen(other) == length && memcmp(data, other, length) == 0;
+    }
+
+    // case-insensitive compare, for header names
+    bool iequals(const char* other) const {
+        for (uint32_t ix = 0; ix < length; ix++) {
+            char a = data[ix], b = other[ix];
+            if (b == '\0') return false;
+            if (a >= 'A' && a <= 'Z') a += 'a' - 'A';
+            if (b >= 'A' && b <= 'Z') b += 'a' - 'A';
+            if (a != b) return false;
+        }
+        return other[length] == '\0';
+    }
+
+    string to_string() const {
+        return string(data, length);
+    }
+};
+
 class HttpResponse {
 public:
     HttpResponse() {
         status_code = 0;
+        status_offset = 0;
+        status_length = 0;
         concat_header_field = false;
         concat_header_value = false;
         expected_content_length = 0;
         is_chunked = false;
         is_message_completed = false;
+        is_content_decoded = false;
         body_length = 0;
+        body_decoded_length = 0;
         body_offset = 0;
+        body_capacity = 0;
+        body_allocations = 0;
+        body_bytes_copied = 0;
+        body_error = false;
         body = NULL;
+        header_arena = NULL;
+        header_arena_length = 0;
+        header_arena_capacity = 0;
+        header_index = NULL;
+        header_index_size = 0;
+        header_index_count = 0;
+        for (uint32_t ix = 0; ix < HTTP_HEADER_KNOWN_COUNT; ix++) {
+            known_headers[ix] = NO_HEADER;
+        }
     }
 
     ~HttpResponse() {
@@ -42,6 +96,14 @@ public:
             free(body);
         }
 
+        if (header_arena != NULL) {
+            free(header_arena);
+        }
+
+        if (header_index != NULL) {
+            free(header_index);
+        }
+
         for (uint32_t ix = 0; ix < header_fields.size(); ix++) {
             delete header_fields[ix];
             delete header_values[ix];
@@ -49,8 +111,22 @@ public:
     }
 
     void set_status(int a_status_code, string a_status_message) {
+        status_length = 0;
+        set_status(a_status_code, a_status_message.c_str(), a_status_message.length());
+    }
+
+    void set_status(int a_status_code, const char *at, uint32_t length) {
         status_code = a_status_code;
-        status_message = a_status_message;
+
+        // the reason phrase can be split over several reads, the pieces arrive back to back in the arena
+        if (status_length == 0 || status_offset + status_length != header_arena_length) {
+            status_offset = header_arena_length;
+            status_length = 0;
+        }
+
+        if (append_to_arena(at, length)) {
+            status_length += length;
+        }
     }
 
     int get_status_code() {
@@ -58,7 +134,15 @@ public:
     }
 
     string get_status_message() {
-        return status_message;
+        return get_status_message_view().to_string();
+    }
+
+    /**
+     * Get the reason phrase of the status line (e.g. "OK"), without copying. See get_header_field().
+     */
+    HttpStringView get_status_message_view() {
+        HttpStringView view = { status_length ? header_arena + status_offset : "", status_length };
+        return view;
     }
 
     void set_url(string a_url) {
@@ -78,80 +162,213 @@ public:
     }
 
     void set_header_field(string field) {
+        set_header_field(field.c_str(), field.length());
+    }
+
+    void set_header_field(const char *at, uint32_t length) {
         concat_header_value = false;
 
-        // headers can be chunked
+        // headers can be chunked, the pieces arrive back to back so they end up next to each other in the arena
         if (concat_header_field) {
-            *header_fields[header_fields.size() - 1] = (*header_fields[header_fields.size() - 1]) + field;
+            if (append_to_arena(at, length)) {
+                headers[headers.size() - 1].field_length += length;
+            }
         }
         else {
-            header_fields.push_back(new string(field));
+            HeaderEntry entry;
+            entry.field_offset = header_arena_length;
+            entry.field_length = length;
+            entry.value_offset = header_arena_length + length;
+            entry.value_length = 0;
+            entry.next_same = NO_HEADER;
+            entry.id = HTTP_HEADER_UNKNOWN;
+
+            if (headers.size() == 0) {
+                headers.reserve(16);
+            }
+
+            if (append_to_arena(at, length)) {
+                headers.push_back(entry);
+            }
         }
 
         concat_header_field = true;
     }
 
     void set_header_value(string value) {
+        set_header_value(value.c_str(), value.length());
+    }
+
+    void set_header_value(const char *at, uint32_t length) {
         concat_header_field = false;
 
-        // headers can be chunked
-        if (concat_header_value) {
-            *header_values[header_values.size() - 1] = (*header_values[header_values.size() - 1]) + value;
+        if (headers.size() == 0) {
+            return;
         }
-        else {
-            header_values.push_back(new string(value));
+
+        HeaderEntry& entry = headers[headers.size() - 1];
+
+        if (!concat_header_value) {
+            entry.value_offset = header_arena_length;
+            entry.value_length = 0;
+
+            // the name is complete once its value starts
+            tag_header(headers.size() - 1);
+        }
+
+        if (append_to_arena(at, length)) {
+            entry.value_length += length;
         }
 
         concat_header_value = true;
     }
 
     void set_headers_complete() {
-        for (uint32_t ix = 0; ix < header_fields.size(); ix++) {
-            if (strcicmp(header_fields[ix]->c_str(), "content-length") == 0) {
-                expected_content_length = (uint32_t)atoi(header_values[ix]->c_str());
-                break;
+        HttpStringView value = get_header(HTTP_HEADER_CONTENT_LENGTH);
+        if (value.data != NULL) {
+            uint32_t content_length = 0;
+            for (uint32_t c = 0; c < value.length && value.data[c] >= '0' && value.data[c] <= '9'; c++) {
+                content_length = content_length * 10 + (value.data[c] - '0');
             }
+            expected_content_length = content_length;
         }
     }
 
+    /**
+     * Get the value of a header (name is case-insensitive), without copying.
+     * If the header occurs more than once, the first value is returned.
+     *
+     * @return View on the value, data is NULL if the header is not present
+     */
+    HttpStringView get_header(const char* name) {
+        http_known_header id = http_lookup_known_header(name, strlen(name));
+        if (id != HTTP_HEADER_UNKNOWN) {
+            return get_header(id);
+        }
+
+        uint32_t ix = find_header(name);
+        if (ix == NO_HEADER) {
+            HttpStringView none = { NULL, 0 };
+            return none;
+        }
+        return get_header_value(ix);
+    }
+
+    /**
+     * Get the value of one of the well-known headers, this does not search at all.
+     *
+     * @return View on the value, data is NULL if the header is not present
+     */
+    HttpStringView get_header(http_known_header id) {
+        if (id >= HTTP_HEADER_KNOWN_COUNT || known_headers[id] == NO_HEADER) {
+            HttpStringView none = { NULL, 0 };
+            return none;
+        }
+        return get_header_value(known_headers[id]);
+    }
+
+    /**
+     * Get all values of a header (name is case-insensitive), in the order they were received.
+     */
+    vector<HttpStringView> get_all_headers(const char* name) {
+        vector<HttpStringView> values;
+        for (uint32_t ix = find_header(name); ix != NO_HEADER; ix = headers[ix].next_same) {
+            values.push_back(get_header_value(ix));
+        }
+        return values;
+    }
+
+    bool has_header(const char* name) {
+        http_known_header id = http_lookup_known_header(name, strlen(name));
+        if (id != HTTP_HEADER_UNKNOWN) {
+            return known_headers[id] != NO_HEADER;
+        }
+
+        return find_header(name) != NO_HEADER;
+    }
+
+    /**
+     * Get the standard header a header was recognized as, so it can be handled without comparing names.
+     *
+     * @return The header, or HTTP_HEADER_UNKNOWN (use get_header_field() for the name)
+     */
+    http_known_header get_header_id(uint32_t ix) {
+        return (http_known_header)headers[ix].id;
+    }
+
     uint32_t get_headers_length() {
-        return header_fields.size();
+        return headers.size();
     }
 
-    vector<string*> get_headers_fields() {
+    /**
+     * Get the name of a header, without copying.
+     * The view stays valid until the response is deleted, but trailers (in chunked responses)
+     * can move the data, so don't hold on to it while the response is still being received.
+     */
+    HttpStringView get_header_field(uint32_t ix) {
+        HttpStringView view = { header_arena + headers[ix].field_offset, headers[ix].field_length };
+        return view;
+    }
+
+    /**
+     * Get the value of a header, without copying. See get_header_field().
+     */
+    HttpStringView get_header_value(uint32_t ix) {
+        HttpStringView view = { header_arena + headers[ix].value_offset, headers[ix].value_length };
+        return view;
+    }
+
+    /**
+     * Get the header names as strings.
+     * The strings are created on the first call, use get_header_field() to avoid the copies.
+     */
+    const vector<string*>& get_headers_fields() {
+        materialize_headers();
         return header_fields;
     }
 
-    vector<string*> get_headers_values() {
+    /**
+     * Get the header values as strings.
+     * The strings are created on the first call, use get_header_value() to avoid the copies.
+     */
+    const vector<string*>& get_headers_values() {
+        materialize_headers();
         return header_values;
     }
 
     void set_body(const char *at, uint32_t length) {
+        // after a chunk was lost the body can't be completed, don't append the next ones after a gap
+        if (body_error) {
+            return;
+        }
+
         // Connection: close, could not specify Content-Length, nor chunked... So do it like this:
         if (expected_content_length == 0 && length > 0) {
             is_chunked = true;
         }
 
         // only malloc when this fn is called, so we don't alloc when body callback's are enabled
-        if (body == NULL && !is_chunked) {
-            body = (char*)malloc(expected_content_length);
-        }
-
-        if (is_chunked) {
-            if (body == NULL) {
-                body = (char*)malloc(length);
+        if (body_offset + length > body_capacity) {
+            uint32_t capacity;
+            if (!is_chunked && !is_content_decoded) {
+                capacity = expected_content_length > body_offset + length ? expected_content_length : body_offset + length;
             }
             else {
-                char* original_body = body;
-                body = (char*)realloc(body, body_offset + length);
-                if (body == NULL) {
-                    free(original_body);
-                    return;
+                // unknown (or decoded) length, grow geometrically so the body is copied O(log n) times instead of on every chunk
+                capacity = body_capacity ? body_capacity : HTTP_RESPONSE_BODY_INITIAL_SIZE;
+                while (capacity < body_offset + length) {
+                    capacity *= 2;
                 }
             }
+
+            if (!resize_body(capacity)) {
+                body_error = true;
+                return;
+            }
         }
 
         memcpy(body + body_offset, at, length);
+        body_bytes_copied += length;
 
         body_offset += length;
     }
@@ -169,6 +386,35 @@ public:
         body_length += length;
     }
 
+    void increase_body_decoded_length(uint32_t length) {
+        body_decoded_length += length;
+    }
+
+    /**
+     * Number of body bytes received, before content decoding (e.g. the compressed size).
+     */
+    uint32_t get_body_encoded_length() {
+        return body_length;
+    }
+
+    /**
+     * Number of body bytes after content decoding. Same as get_body_encoded_length() if the body was not decoded.
+     */
+    uint32_t get_body_decoded_length() {
+        return body_decoded_length;
+    }
+
+    void set_content_decoded() {
+        is_content_decoded = true;
+    }
+
+    /**
+     * Whether the body was decoded (e.g. decompressed) according to its Content-Encoding.
+     */
+    bool get_content_decoded() {
+        return is_content_decoded;
+    }
+
     uint32_t get_body_length() {
         return body_offset;
     }
@@ -183,32 +429,209 @@ public:
 
     void set_message_complete() {
         is_message_completed = true;
+
+        // give back the unused part of a geometrically grown body
+        if ((is_chunked || is_content_decoded) && body_offset > 0 && body_capacity > body_offset) {
+            resize_body(body_offset);
+        }
+    }
+
+    /**
+     * NSAPI_ERROR_NO_MEMORY if the body buffer could not grow. The body then holds the data received
+     * before that, and nothing after it.
+     */
+    nsapi_error_t get_body_error() {
+        return body_error ? NSAPI_ERROR_NO_MEMORY : NSAPI_ERROR_OK;
+    }
+
+    /**
+     * Number of times the body buffer was allocated or resized.
+     */
+    uint32_t get_body_allocations() {
+        return body_allocations;
+    }
+
+    /**
+     * Number of body bytes copied: received data copied into the body buffer, plus data moved
+     * when resizing the buffer had to move it.
+     */
+    uint32_t get_body_bytes_copied() {
+        return body_bytes_copied;
     }
 
 private:
-    // from http://stackoverflow.com/questions/5820810/case-insensitive-string-comp-in-c
-    int strcicmp(char const *a, char const *b) {
-        for (;; a++, b++) {
-            int d = tolower(*a) - tolower(*b);
-            if (d != 0 || !*a) {
-                return d;
+    static const uint32_t NO_HEADER = 0xFFFFFFFF;
+
+    bool resize_body(uint32_t capacity) {
+        char* new_body = (char*)realloc(body, capacity);
+        if (new_body == NULL) {
+            return false;
+        }
+
+        body_allocations++;
+        if (body != NULL && new_body != body) {
+            body_bytes_copied += body_offset;
+        }
+
+        body = new_body;
+        body_capacity = capacity;
+        return true;
+    }
+
+    struct HeaderEntry {
+        uint32_t field_offset;
+        uint32_t field_length;
+        uint32_t value_offset;
+        uint32_t value_length;
+        uint32_t next_same; // next header with the same name, or NO_HEADER
+        uint8_t id;         // http_known_header
+    };
+
+    void tag_header(uint32_t ix) {
+        HttpStringView field = get_header_field(ix);
+        http_known_header id = http_lookup_known_header(field.data, field.length);
+
+        headers[ix].id = id;
+        if (id != HTTP_HEADER_UNKNOWN && known_headers[id] == NO_HEADER) {
+            known_headers[id] = ix;
+        }
+    }
+
+    // FNV-1a over the lower-cased name
+    static uint32_t hash_name(const char* data, uint32_t length) {
+        uint32_t hash = 2166136261u;
+        for (uint32_t ix = 0; ix < length; ix++) {
+            char c = data[ix];
+            if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+            hash = (hash ^ (uint8_t)c) * 16777619u;
+        }
+        return hash;
+    }
+
+    // open addressing table of header indexes, holds the first header of every name,
+    // duplicates are chained through next_same. Built on the first lookup, rebuilt when trailers arrive.
+    void build_header_index() {
+        if (header_index != NULL && header_index_count == headers.size()) {
+            return;
+        }
+
+        uint32_t size = 8;
+        while (size < headers.size() * 2) {
+            size *= 2;
+        }
+
+        uint32_t* index = (uint32_t*)realloc(header_index, size * sizeof(uint32_t));
+        if (index == NULL) {
+            return;
+        }
+        header_index = index;
+        header_index_size = size;
+        header_index_count = headers.size();
+
+        for (uint32_t ix = 0; ix < size; ix++) {
+            header_index[ix] = NO_HEADER;
+        }
+
+        for (uint32_t ix = 0; ix < headers.size(); ix++) {
+            HttpStringView field = get_header_field(ix);
+            headers[ix].next_same = NO_HEADER;
+
+            uint32_t slot = hash_name(field.data, field.length) & (size - 1);
+            while (header_index[slot] != NO_HEADER) {
+                HttpStringView other = get_header_field(header_index[slot]);
+                if (other.length == field.length && names_equal(other.data, field.data, field.length)) {
+                    break;
+                }
+                slot = (slot + 1) & (size - 1);
+            }
+
+            if (header_index[slot] == NO_HEADER) {
+                header_index[slot] = ix;
+            }
+            else {
+                // append to the end of the chain, so values stay in order
+                uint32_t last = header_index[slot];
+                while (headers[last].next_same != NO_HEADER) {
+                    last = headers[last].next_same;
+                }
+                headers[last].next_same = ix;
             }
         }
     }
 
-    char tolower(char c) {
-        if(('A' <= c) && (c <= 'Z')) {
-            return 'a' + (c - 'A');
+    uint32_t find_header(const char* name) {
+        build_header_index();
+        if (header_index == NULL) {
+            return NO_HEADER;
         }
 
-        return c;
+        uint32_t length = strlen(name);
+        uint32_t slot = hash_name(name, length) & (header_index_size - 1);
+        while (header_index[slot] != NO_HEADER) {
+            HttpStringView field = get_header_field(header_index[slot]);
+            if (field.length == length && names_equal(field.data, name, length)) {
+                return header_index[slot];
+            }
+            slot = (slot + 1) & (header_index_size - 1);
+        }
+        return NO_HEADER;
+    }
+
+    static bool names_equal(const char* a, const char* b, uint32_t length) {
+        for (uint32_t ix = 0; ix < length; ix++) {
+            char ca = a[ix], cb = b[ix];
+            if (ca >= 'A' && ca <= 'Z') ca += 'a' - 'A';
+            if (cb >= 'A' && cb <= 'Z') cb += 'a' - 'A';
+            if (ca != cb) return false;
+        }
+        return true;
+    }
+
+    bool append_to_arena(const char *at, uint32_t length) {
+        if (header_arena_length + length > header_arena_capacity) {
+            uint32_t capacity = header_arena_capacity ? header_arena_capacity : HTTP_RESPONSE_HEADERS_INITIAL_SIZE;
+            while (capacity < header_arena_length + length) {
+                capacity *= 2;
+            }
+
+            char* new_arena = (char*)realloc(header_arena, capacity);
+            if (new_arena == NULL) {
+                return false;
+            }
+            header_arena = new_arena;
+            header_arena_capacity = capacity;
+        }
+
+        memcpy(header_arena + header_arena_length, at, length);
+        header_arena_length += length;
+        return true;
+    }
+
+    void materialize_headers() {
+        for (uint32_t ix = header_fields.size(); ix < headers.size(); ix++) {
+            header_fields.push_back(new string(get_header_field(ix).to_string()));
+            header_values.push_back(new string(get_header_value(ix).to_string()));
+        }
     }
 
     int status_code;
-    string status_message;
+    uint32_t status_offset;
+    uint32_t status_length;
     string url;
     http_method method;
 
+    // the reason phrase and all header names and values are stored back to back in one buffer
+    char* header_arena;
+    uint32_t header_arena_length;
+    uint32_t header_arena_capacity;
+    vector<HeaderEntry> headers;
+
+    uint32_t known_headers[HTTP_HEADER_KNOWN_COUNT];
+    uint32_t* header_index;
+    uint32_t header_index_size;
+    uint32_t header_index_count;
+
+    // only filled when get_headers_fields() / get_headers_values() are used
     vector<string*> header_fields;
     vector<string*> header_values;
 
@@ -221,9 +644,16 @@ private:
 
     bool is_message_completed;
 
+    bool is_content_decoded;
+
     char * body;
     uint32_t body_length;
+    uint32_t body_decoded_length;
     uint32_t body_offset;
+    uint32_t body_capacity;
+    uint32_t body_allocations;
+    uint32_t body_bytes_copied;
+    bool body_error;
 };
 
 #endif
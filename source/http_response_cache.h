@@ -0,0 +1,789 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MBED_HTTP_RESPONSE_CACHE_H_
+#define _MBED_HTTP_RESPONSE_CACHE_H_
+
+#include <string>
+#include <vector>
+#include "mbed.h"
+#include "FileSystem.h"
+#include "File.h"
+#include "Dir.h"
+#include "http_response.h"
+
+#ifndef HTTP_CACHE_MAX_ENTRY_SIZE
+#define HTTP_CACHE_MAX_ENTRY_SIZE 4096
+#endif
+
+#ifndef HTTP_CACHE_MEMORY_SIZE
+#define HTTP_CACHE_MEMORY_SIZE 16 * 1024
+#endif
+
+#ifndef HTTP_CACHE_MEMORY_ENTRIES
+#define HTTP_CACHE_MEMORY_ENTRIES 16
+#endif
+
+using namespace std;
+
+/**
+ * \brief ResponseCacheStorage keeps serialized responses by key, for a ResponseCache.
+ *
+ * Implement it to keep cached responses anywhere. Calls are serialized by the cache.
+ */
+class ResponseCacheStorage {
+public:
+    virtual ~ResponseCacheStorage() {}
+
+    /**
+     * Store (or replace) an entry.
+     */
+    virtual nsapi_error_t store(const char* key, const char* data, uint32_t size) = 0;
+
+    /**
+     * Load an entry.
+     *
+     * @param[out] size Size of the entry
+     * @return The entry in a buffer allocated with malloc(), the caller frees it. NULL if there is no entry.
+     */
+    virtual char* load(const char* key, uint32_t* size) = 0;
+
+    /**
+     * Remove an entry, if present.
+     */
+    virtual void remove(const char* key) = 0;
+
+    /**
+     * Remove all entries.
+     */
+    virtual void clear() = 0;
+};
+
+/**
+ * \brief MemoryCacheStorage keeps entries on the heap, and drops the least recently used ones to stay within its limits.
+ */
+class MemoryCacheStorage : public ResponseCacheStorage {
+public:
+    /**
+     * MemoryCacheStorage Constructor
+     *
+     * @param[in] max_size Maximum number of bytes of all entries together
+     * @param[in] max_entries Maximum number of entries
+     */
+    MemoryCacheStorage(uint32_t max_size = HTTP_CACHE_MEMORY_SIZE, uint32_t max_entries = HTTP_CACHE_MEMORY_ENTRIES)
+        : _max_size(max_size), _max_entries(max_entries), _size(0), _evictions(0)
+    {}
+
+    virtual ~MemoryCacheStorage() {
+        clear();
+    }
+
+    virtual nsapi_error_t store(const char* key, const char* data, uint32_t size) {
+        remove(key);
+
+        if (size > _max_size) {
+            return NSAPI_ERROR_NO_MEMORY;
+        }
+
+        // entries are in order of use, drop the least recently used ones
+        while (_entries.size() > 0 && (_entries.size() >= _max_entries || _size + size > _max_size)) {
+            erase(0);
+            _evictions++;
+        }
+
+        Entry entry;
+        entry.data = (char*)malloc(size);
+        if (!entry.data) {
+            return NSAPI_ERROR_NO_MEMORY;
+        }
+        memcpy(entry.data, data, size);
+        entry.key = key;
+        entry.size = size;
+        _entries.push_back(entry);
+        _size += size;
+        return NSAPI_ERROR_OK;
+    }
+
+    virtual char* load(const char* key, uint32_t* size) {
+        int ix = find(key);
+        if (ix < 0) {
+            return NULL;
+        }
+
+        // most recently used goes to the back
+        Entry entry = _entries[ix];
+        _entries.erase(_entries.begin() + ix);
+        _entries.push_back(entry);
+
+        char* data = (char*)malloc(entry.size);
+        if (!data) {
+            return NULL;
+        }
+        memcpy(data, entry.data, entry.size);
+        *size = entry.size;
+        return data;
+    }
+
+    virtual void remove(const char* key) {
+        int ix = find(key);
+        if (ix >= 0) {
+            erase(ix);
+        }
+    }
+
+    virtual void clear() {
+        while (_entries.size() > 0) {
+            erase(0);
+        }
+    }
+
+    /**
+     * Number of bytes used by all entries.
+     */
+    uint32_t get_size() {
+        return _size;
+    }
+
+    /**
+     * Number of entries.
+     */
+    uint32_t get_entries() {
+        return _entries.size();
+    }
+
+    /**
+     * Number of entries dropped to make room for new ones.
+     */
+    uint32_t get_evictions() {
+        return _evictions;
+    }
+
+private:
+    struct Entry {
+        string key;
+        char* data;
+        uint32_t size;
+    };
+
+    int find(const char* key) {
+        for (size_t ix = 0; ix < _entries.size(); ix++) {
+            if (_entries[ix].key == key) {
+                return ix;
+            }
+        }
+        return -1;
+    }
+
+    void erase(size_t ix) {
+        _size -= _entries[ix].size;
+        free(_entries[ix].data);
+        _entries.erase(_entries.begin() + ix);
+    }
+
+    uint32_t _max_size;
+    uint32_t _max_entries;
+    uint32_t _size;
+    uint32_t _evictions;
+    vector<Entry> _entries;
+};
+
+/**
+ * \brief FileCacheStorage keeps every entry in its own file in a directory on an mbed FileSystem,
+ * so the cache survives a reset. File names are a hash of the key; the cache checks the key stored in the entry.
+ */
+class FileCacheStorage : public ResponseCacheStorage {
+public:
+    /**
+     * FileCacheStorage Constructor
+     *
+     * @param[in] fs A mounted file system, needs to outlive the storage
+     * @param[in] directory Directory for the entries (created if it does not exist), relative to the file system
+     */
+    FileCacheStorage(FileSystem* fs, const char* directory)
+        : _fs(fs), _directory(directory)
+    {
+        _fs->mkdir(directory, 0777);
+    }
+
+    virtual nsapi_error_t store(const char* key, const char* data, uint32_t size) {
+        string path = entry_path(key);
+
+        File file;
+        if (file.open(_fs, path.c_str(), O_WRONLY | O_CREAT | O_TRUNC) != 0) {
+            return NSAPI_ERROR_DEVICE_ERROR;
+        }
+
+        bool ok = file.write(data, size) == (ssize_t)size;
+        file.close();
+
+        if (!ok) {
+            // don't leave a partial entry behind
+            _fs->remove(path.c_str());
+            return NSAPI_ERROR_DEVICE_ERROR;
+        }
+        return NSAPI_ERROR_OK;
+    }
+
+    virtual char* load(const char* key, uint32_t* size) {
+        File file;
+        if (file.open(_fs, entry_path(key).c_str(), O_RDONLY) != 0) {
+            return NULL;
+        }
+
+        off_t file_size = file.size();
+        char* data = file_size > 0 ? (char*)malloc(file_size) : NULL;
+        if (data && file.read(data, file_size) != (ssize_t)file_size) {
+            free(data);
+            data = NULL;
+        }
+        file.close();
+
+        *size = file_size;
+        return data;
+    }
+
+    virtual void remove(const char* key) {
+        _fs->remove(entry_path(key).c_str());
+    }
+
+    virtual void clear() {
+        Dir dir;
+        if (dir.open(_fs, _directory.c_str()) != 0) {
+            return;
+        }
+
+        // collect the names first, removing while iterating is not safe on every file system
+        vector<string> names;
+        struct dirent ent;
+        while (dir.read(&ent) > 0) {
+            size_t length = strlen(ent.d_name);
+            if (length > 4 && strcmp(ent.d_name + length - 4, ".rsp") == 0) {
+                names.push_back(ent.d_name);
+            }
+        }
+        dir.close();
+
+        for (size_t ix = 0; ix < names.size(); ix++) {
+            _fs->remove((_directory + "/" + names[ix]).c_str());
+        }
+    }
+
+private:
+    string entry_path(const char* key) {
+        // FNV-1a
+        uint32_t hash = 2166136261u;
+        for (const char* c = key; *c; c++) {
+            hash = (hash ^ (uint8_t)*c) * 16777619u;
+        }
+
+        char name[16];
+        snprintf(name, sizeof(name), "/%08lx.rsp", (unsigned long)hash);
+        return _directory + name;
+    }
+
+    FileSystem* _fs;
+    string _directory;
+};
+
+/**
+ * A response loaded from a ResponseCache.
+ */
+class ResponseCacheEntry {
+public:
+    ResponseCacheEntry(char* data, uint32_t size)
+        : _data(data), _size(size)
+    {
+        memcpy(&_header, data, sizeof(_header));
+    }
+
+    ~ResponseCacheEntry() {
+        free(_data);
+    }
+
+    /**
+     * Whether the entry can be used without asking the server.
+     * After a reset the millisecond counter starts over, then stored entries are stale.
+     */
+    bool is_fresh() {
+        uint64_t now = Kernel::get_ms_count();
+        return now >= _header.stored_ms && now - _header.stored_ms < _header.max_age_ms;
+    }
+
+    /**
+     * Value of a stored header (case-insensitive name), data is NULL if not present.
+     */
+    HttpStringView get_header(const char* name) {
+        HttpStringView result = { NULL, 0 };
+        const char* p = headers();
+        for (uint32_t ix = 0; ix < _header.header_count; ix++) {
+            HttpStringView field = read_string(&p);
+            HttpStringView value = read_string(&p);
+            if (result.data == NULL && field.iequals(name)) {
+                result = value;
+            }
+        }
+        return result;
+    }
+
+    /**
+     * Create a response from the entry.
+     *
+     * @param with_body Copy the body into the response (otherwise only its length is set)
+     */
+    HttpResponse* create_response(bool with_body) {
+        HttpResponse* res = new HttpResponse();
+
+        const char* p = _data + sizeof(_header) + _header.key_length;
+        HttpStringView status = read_string(&p);
+        res->set_status(_header.status_code, status.data, status.length);
+
+        for (uint32_t ix = 0; ix < _header.header_count; ix++) {
+            HttpStringView field = read_string(&p);
+            HttpStringView value = read_string(&p);
+            res->set_header_field(field.data, field.length);
+            res->set_header_value(value.data, value.length);
+        }
+        res->set_headers_complete();
+
+        if (_header.content_decoded) {
+            res->set_content_decoded();
+        }
+        if (with_body) {
+            res->set_body(p, _header.body_length);
+        }
+        res->increase_body_length(_header.body_length);
+        res->increase_body_decoded_length(_header.body_length);
+        res->set_message_complete();
+        return res;
+    }
+
+    const char* get_body() {
+        return _data + _size - _header.body_length;
+    }
+
+    uint32_t get_body_length() {
+        return _header.body_length;
+    }
+
+private:
+    friend class ResponseCache;
+
+    // layout of an entry: this header, the key, the status message, the header fields and values
+    // (every string prefixed with its length), then the body
+    struct Header {
+        uint32_t magic;
+        uint32_t status_code;
+        uint64_t stored_ms;
+        uint32_t max_age_ms;
+        uint32_t key_length;
+        uint32_t header_count;
+        uint32_t body_length;
+        uint32_t content_decoded;
+    };
+
+    static const uint32_t MAGIC = 0x48524331; // 'HRC1'
+
+    const char* headers() {
+        const char* p = _data + sizeof(_header) + _header.key_length;
+        read_string(&p); // status message
+        return p;
+    }
+
+    static HttpStringView read_string(const char** p) {
+        uint32_t length;
+        memcpy(&length, *p, sizeof(length));
+        HttpStringView view = { *p + sizeof(length), length };
+        *p += sizeof(length) + length;
+        return view;
+    }
+
+    char* _data;
+    uint32_t _size;
+    Header _header;
+};
+
+/**
+ * \brief ResponseCache keeps responses to GET requests, and serves them again while they're fresh.
+ *
+ * Attach it to requests with HttpRequestBase::set_response_cache(). Responses with status 200 are stored
+ * (in a ResponseCacheStorage) if they're allowed (no 'Cache-Control: no-store' or 'private', and no 'Vary'
+ * on other request headers than Accept-Encoding, which is part of the key) and useful: they have a
+ * max-age, or an ETag or Last-Modified to revalidate them with. The max-age counts from when the response
+ * was created, so the 'Age' it spent in other caches is taken off.
+ * Requests with an Authorization header don't use the cache.
+ *
+ * A fresh entry (younger than its max-age) is returned without any network traffic. For a stale entry the request
+ * is sent with If-None-Match and/or If-Modified-Since; a '304 Not Modified' response is turned into the cached
+ * response, and the entry is fresh again for the max-age of the 304 (or of the stored response).
+ *
+ * A cache can be shared between requests and between threads.
+ */
+class ResponseCache {
+public:
+    /**
+     * ResponseCache Constructor
+     *
+     * @param[in] storage Where the entries are kept, needs to outlive the cache
+     * @param[in] max_entry_size Responses that serialize to more bytes than this are not stored
+     */
+    ResponseCache(ResponseCacheStorage* storage, uint32_t max_entry_size = HTTP_CACHE_MAX_ENTRY_SIZE)
+        : _storage(storage), _max_entry_size(max_entry_size), _lookups(0), _hits(0), _revalidations(0), _misses(0), _stores(0)
+    {}
+
+    /**
+     * Load the entry for a key.
+     *
+     * @param[out] fresh Whether the entry can be used without asking the server
+     * @return The entry (delete it when done), or NULL if there is none
+     */
+    ResponseCacheEntry* lookup(const char* key, bool* fresh) {
+        _mutex.lock();
+        _lookups++;
+
+        uint32_t size = 0;
+        char* data = _storage->load(key, &size);
+        ResponseCacheEntry* entry = data ? parse(key, data, size) : NULL;
+
+        *fresh = entry && entry->is_fresh();
+        if (!entry) {
+            _misses++;
+        }
+        else if (*fresh) {
+            _hits++;
+        }
+        _mutex.unlock();
+
+        return entry;
+    }
+
+    /**
+     * Store a received response, if it can be cached.
+     *
+     * @return true if the response was stored
+     */
+    bool store(const char* key, HttpResponse* res) {
+        if (res->get_status_code() != 200 || !res->is_message_complete()) {
+            return false;
+        }
+
+        bool no_store = false, no_cache = false;
+        int32_t max_age = parse_cache_control(res->get_header(HTTP_HEADER_CACHE_CONTROL), &no_store, &no_cache);
+        max_age = subtract_age(res, max_age);
+        bool validator = res->get_header(HTTP_HEADER_ETAG).data || res->get_header(HTTP_HEADER_LAST_MODIFIED).data;
+
+        if (no_store || (max_age <= 0 && !validator) || !is_vary_supported(res->get_header(HTTP_HEADER_VARY))) {
+            return false;
+        }
+
+        uint32_t size = 0;
+        char* data = serialize(key, res, no_cache ? 0 : max_age, &size);
+        if (!data) {
+            return false;
+        }
+
+        _mutex.lock();
+        nsapi_error_t ret = _storage->store(key, data, size);
+        if (ret == NSAPI_ERROR_OK) {
+            _stores++;
+        }
+        _mutex.unlock();
+
+        free(data);
+        return ret == NSAPI_ERROR_OK;
+    }
+
+    /**
+     * The server confirmed a stale entry with '304 Not Modified', make it fresh again.
+     */
+    void revalidated(const char* key, ResponseCacheEntry* entry, HttpResponse* not_modified) {
+        bool no_store = false, no_cache = false;
+        int32_t max_age = parse_cache_control(not_modified->get_header(HTTP_HEADER_CACHE_CONTROL), &no_store, &no_cache);
+
+        entry->_header.stored_ms = Kernel::get_ms_count();
+        if (no_cache) {
+            entry->_header.max_age_ms = 0;
+        }
+        else if (max_age >= 0) {
+            entry->_header.max_age_ms = max_age_to_ms(subtract_age(not_modified, max_age));
+        }
+        memcpy(entry->_data, &entry->_header, sizeof(entry->_header));
+
+        _mutex.lock();
+        _revalidations++;
+        if (no_store) {
+            _storage->remove(key);
+        }
+        else {
+            _storage->store(key, entry->_data, entry->_size);
+        }
+        _mutex.unlock();
+    }
+
+    /**
+     * Remove the entry for a key.
+     */
+    void invalidate(const char* key) {
+        _mutex.lock();
+        _storage->remove(key);
+        _mutex.unlock();
+    }
+
+    /**
+     * Remove all entries.
+     */
+    void clear() {
+        _mutex.lock();
+        _storage->clear();
+        _mutex.unlock();
+    }
+
+    /**
+     * Number of requests that looked in the cache.
+     */
+    uint32_t get_lookups() {
+        return _lookups;
+    }
+
+    /**
+     * Number of requests served from a fresh entry, without network traffic.
+     */
+    uint32_t get_hits() {
+        return _hits;
+    }
+
+    /**
+     * Number of requests served from a stale entry after the server replied with 304.
+     */
+    uint32_t get_revalidations() {
+        return _revalidations;
+    }
+
+    /**
+     * Number of requests that found no entry.
+     */
+    uint32_t get_misses() {
+        return _misses;
+    }
+
+    /**
+     * Number of responses stored.
+     */
+    uint32_t get_stores() {
+        return _stores;
+    }
+
+    /**
+     * Share of the lookups that were answered with a cached body (hits and revalidations), between 0 and 1.
+     */
+    float get_hit_ratio() {
+        return _lookups == 0 ? 0.0f : (float)(_hits + _revalidations) / _lookups;
+    }
+
+private:
+    ResponseCacheEntry* parse(const char* key, char* data, uint32_t size) {
+        ResponseCacheEntry::Header header;
+        uint32_t key_length = strlen(key);
+
+        // entries from another version, a hash collision (file storage) or a partial write are dropped
+        if (size < sizeof(header)) {
+            free(data);
+            return NULL;
+        }
+        memcpy(&header, data, sizeof(header));
+        if (header.magic != ResponseCacheEntry::MAGIC || header.key_length != key_length
+            || (uint64_t)sizeof(header) + key_length + header.body_length > size
+            || memcmp(data + sizeof(header), key, key_length) != 0
+            || !strings_fit(data + sizeof(header) + key_length, size - sizeof(header) - key_length,
+                            1 + 2 * (uint64_t)header.header_count, header.body_length)) {
+            free(data);
+            return NULL;
+        }
+
+        return new ResponseCacheEntry(data, size);
+    }
+
+    // Checks that count length-prefixed strings, followed by exactly body_length bytes, make up the size bytes at p.
+    // A truncated entry can pass the other checks, and read_string() trusts the lengths.
+    static bool strings_fit(const char* p, uint32_t size, uint64_t count, uint32_t body_length) {
+        for (uint64_t ix = 0; ix < count; ix++) {
+            uint32_t length;
+            if (size < sizeof(length)) {
+                return false;
+            }
+            memcpy(&length, p, sizeof(length));
+            p += sizeof(length);
+            size -= sizeof(length);
+
+            if (length > size) {
+                return false;
+            }
+            p += length;
+            size -= length;
+        }
+        return size == body_length;
+    }
+
+    char* serialize(const char* key, HttpResponse* res, int32_t max_age, uint32_t* out_size) {
+        ResponseCacheEntry::Header header;
+        header.magic = ResponseCacheEntry::MAGIC;
+        header.status_code = res->get_status_code();
+        header.stored_ms = Kernel::get_ms_count();
+        header.max_age_ms = max_age > 0 ? max_age_to_ms(max_age) : 0;
+        header.key_length = strlen(key);
+        header.header_count = res->get_headers_length();
+        header.body_length = res->get_body_length();
+        header.content_decoded = res->get_content_decoded();
+
+        HttpStringView status = res->get_status_message_view();
+
+        uint32_t size = sizeof(header) + header.key_length + sizeof(uint32_t) + status.length + header.body_length;
+        for (uint32_t ix = 0; ix < header.header_count; ix++) {
+            size += 2 * sizeof(uint32_t) + res->get_header_field(ix).length + res->get_header_value(ix).length;
+        }
+        if (size > _max_entry_size) {
+            return NULL;
+        }
+
+        char* data = (char*)malloc(size);
+        if (!data) {
+            return NULL;
+        }
+
+        char* p = data;
+        memcpy(p, &header, sizeof(header));
+        p += sizeof(header);
+        memcpy(p, key, header.key_length);
+        p += header.key_length;
+        p = write_string(p, status.data, status.length);
+        for (uint32_t ix = 0; ix < header.header_count; ix++) {
+            HttpStringView field = res->get_header_field(ix);
+            HttpStringView value = res->get_header_value(ix);
+            p = write_string(p, field.data, field.length);
+            p = write_string(p, value.data, value.length);
+        }
+        if (header.body_length > 0) {
+            memcpy(p, res->get_body(), header.body_length);
+        }
+
+        *out_size = size;
+        return data;
+    }
+
+    static char* write_string(char* p, const char* data, uint32_t length) {
+        memcpy(p, &length, sizeof(length));
+        if (length > 0) {
+            memcpy(p + sizeof(length), data, length);
+        }
+        return p + sizeof(length) + length;
+    }
+
+    static uint32_t max_age_to_ms(int32_t max_age) {
+        return (uint32_t)max_age > 0xFFFFFFFF / 1000 ? 0xFFFFFFFF : (uint32_t)max_age * 1000;
+    }
+
+    // The part of max-age (in seconds) that is left after the response spent 'Age' seconds in other caches
+    static int32_t subtract_age(HttpResponse* res, int32_t max_age) {
+        HttpStringView age = res->get_header(HTTP_HEADER_AGE);
+        if (max_age <= 0 || !age.data) {
+            return max_age;
+        }
+
+        uint32_t seconds = 0;
+        for (uint32_t ix = 0; ix < age.length && age.data[ix] >= '0' && age.data[ix] <= '9'; ix++) {
+            seconds = seconds > 0x7FFFFFF ? 0x7FFFFFFF : seconds * 10 + (age.data[ix] - '0');
+        }
+        return seconds >= (uint32_t)max_age ? 0 : max_age - seconds;
+    }
+
+    // Entries are keyed on the URL and Accept-Encoding, so a response can only vary on the latter
+    static bool is_vary_supported(HttpStringView value) {
+        if (!value.data) {
+            return true;
+        }
+
+        const char* p = value.data;
+        const char* end = value.data + value.length;
+        while (p < end) {
+            while (p < end && (*p == ' ' || *p == ',')) p++;
+
+            const char* token = p;
+            while (p < end && *p != ',') p++;
+            HttpStringView name = { token, (uint32_t)(p - token) };
+            while (name.length > 0 && name.data[name.length - 1] == ' ') name.length--;
+
+            if (name.length > 0 && !name.iequals("accept-encoding")) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Returns max-age in seconds, or -1 if not present.
+    // The cache can be shared between requests, so 'private' responses are treated like 'no-store'.
+    static int32_t parse_cache_control(HttpStringView value, bool* no_store, bool* no_cache) {
+        int32_t max_age = -1;
+        if (!value.data) {
+            return max_age;
+        }
+
+        const char* p = value.data;
+        const char* end = value.data + value.length;
+        while (p < end) {
+            while (p < end && (*p == ' ' || *p == ',')) p++;
+
+            const char* token = p;
+            while (p < end && *p != ',' && *p != '=') p++;
+            HttpStringView name = { token, (uint32_t)(p - token) };
+            while (name.length > 0 && name.data[name.length - 1] == ' ') name.length--;
+
+            uint32_t number = 0;
+            bool has_number = false;
+            if (p < end && *p == '=') {
+                p++;
+                if (p < end && *p == '"') p++;
+                for (; p < end && *p >= '0' && *p <= '9'; p++) {
+                    number = number > 0x7FFFFFF ? 0x7FFFFFFF : number * 10 + (*p - '0');
+                    has_number = true;
+                }
+                while (p < end && *p != ',') p++;
+            }
+
+            if (name.iequals("no-store") || name.iequals("private")) {
+                *no_store = true;
+            }
+            else if (name.iequals("no-cache")) {
+                *no_cache = true;
+            }
+            else if (name.iequals("max-age") && has_number) {
+                max_age = number;
+            }
+        }
+        return max_age;
+    }
+
+    ResponseCacheStorage* _storage;
+    uint32_t _max_entry_size;
+
+    uint32_t _lookups;
+    uint32_t _hits;
+    uint32_t _revalidations;
+    uint32_t _misses;
+    uint32_t _stores;
+    PlatformMutex _mutex;
+};
+
+#endif // _MBED_HTTP_RESPONSE_CACHE_H_
@@ -0,0 +1,400 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MBED_HTTP_RESUMABLE_DOWNLOAD_H_
+#define _MBED_HTTP_RESUMABLE_DOWNLOAD_H_
+
+#include <string>
+#include "mbed.h"
+#include "http_body_sink.h"
+#include "http_download_base.h"
+
+#ifndef HTTP_DOWNLOAD_CHECKPOINT_SIZE
+#define HTTP_DOWNLOAD_CHECKPOINT_SIZE 16 * 1024
+#endif
+
+#ifndef HTTP_DOWNLOAD_VALIDATOR_SIZE
+#define HTTP_DOWNLOAD_VALIDATOR_SIZE 64
+#endif
+
+using namespace std;
+
+/**
+ * Progress of a download, store it next to the data to resume the download later (e.g. after a reboot).
+ */
+struct DownloadState {
+    uint32_t offset;    // number of bytes stored in the sink
+    uint32_t total;     // size of the resource, 0 if not known (yet)
+    char validator[HTTP_DOWNLOAD_VALIDATOR_SIZE];   // strong ETag or Last-Modified of the resource, empty if none
+};
+
+/**
+ * \brief ResumableDownload fetches a resource into a BodySink, and continues where it stopped when the connection drops.
+ *
+ * Every attempt is a new GET request. Once part of the resource was received, the next attempt asks for the
+ * rest with 'Range: bytes=offset-', and with 'If-Range' set to the ETag (or Last-Modified) of the resource:
+ * - 206 Partial Content: the body is appended to the sink.
+ * - 200 OK: the resource changed, or the server does not do ranges. The sink is rewound and filled from the start.
+ *
+ * Every HTTP_DOWNLOAD_CHECKPOINT_SIZE bytes, and when an attempt fails, the sink is flushed and the state callback
+ * is called with the progress. Store the state, and pass it to set_state() to resume after a reset.
+ */
+class ResumableDownload : public HttpDownloadBase {
+public:
+    /**
+     * ResumableDownload Constructor, for http:// URLs
+     *
+     * @param[in] network The network interface
+     * @param[in] url URL to the resource
+     * @param[in] sink Where the resource is stored, needs to outlive the download
+     */
+    ResumableDownload(NetworkInterface* network, const char* url, BodySink* sink)
+        : HttpDownloadBase(network, url, NULL, NULL), _sink(sink)
+    {
+        init();
+    }
+
+    /**
+     * ResumableDownload Constructor, for https:// URLs
+     *
+     * @param[in] network The network interface
+     * @param[in] ssl_ca_pem String containing the trusted CAs
+     * @param[in] url URL to the resource
+     * @param[in] sink Where the resource is stored, needs to outlive the download
+     */
+    ResumableDownload(NetworkInterface* network, const char* ssl_ca_pem, const char* url, BodySink* sink)
+        : HttpDownloadBase(network, url, ssl_ca_pem, NULL), _sink(sink)
+    {
+        init();
+    }
+
+    /**
+     * ResumableDownload Constructor, for https:// URLs
+     *
+     * @param[in] network The network interface
+     * @param[in] ca_store Store containing the trusted CAs, needs to outlive the download
+     * @param[in] url URL to the resource
+     * @param[in] sink Where the resource is stored, needs to outlive the download
+     */
+    ResumableDownload(NetworkInterface* network, CertificateStore* ca_store, const char* url, BodySink* sink)
+        : HttpDownloadBase(network, url, NULL, ca_store), _sink(sink)
+    {
+        init();
+    }
+
+    /**
+     * Resume from a stored state. The sink needs to continue at state.offset (e.g. a file opened for appending).
+     */
+    void set_state(const DownloadState& state) {
+        _state = state;
+        _state.validator[HTTP_DOWNLOAD_VALIDATOR_SIZE - 1] = '\0';
+    }
+
+    /**
+     * Get the progress of the download.
+     */
+    DownloadState get_state() {
+        return _state;
+    }
+
+    /**
+     * Set a callback that is called after the sink was flushed, with the progress to store.
+     * Not called for sinks that cannot be flushed (flush() returns NSAPI_ERROR_UNSUPPORTED).
+     */
+    void set_state_callback(Callback<void(const DownloadState*)> state_cb) {
+        _state_cb = state_cb;
+    }
+
+    /**
+     * Set a callback that is called with every request before it is sent, e.g. to add headers,
+     * or to set a connection pool or DNS cache.
+     */
+    void set_request_callback(Callback<void(HttpRequestBase*)> request_cb) {
+        _request_cb = request_cb;
+    }
+
+    /**
+     * Set how often the download is tried, and how long to wait between the attempts.
+     */
+    void set_retry(uint32_t max_attempts, uint32_t retry_delay_ms) {
+        _max_attempts = max_attempts < 1 ? 1 : max_attempts;
+        _retry_delay_ms = retry_delay_ms;
+    }
+
+    /**
+     * Download the (rest of the) resource. Blocks until it is complete, or the attempts ran out.
+     *
+     * @return NSAPI_ERROR_OK when the complete resource is in the sink (and the sink was finished),
+     *         -2103 if the server replied with an unexpected status (see get_status_code()) or Content-Range,
+     *         the error of the sink, or the error of the last attempt.
+     */
+    nsapi_error_t run() {
+        _attempts = 0;
+
+        while (true) {
+            _attempts++;
+
+            bool retry = false;
+            _error = attempt(&retry);
+
+            if (_error == NSAPI_ERROR_OK) {
+                _error = _sink->complete();
+                return _error;
+            }
+
+            // keep what was received so far
+            if (_sink->get_error() == NSAPI_ERROR_OK) {
+                nsapi_error_t ret = checkpoint();
+                if (ret != NSAPI_ERROR_OK) {
+                    _error = ret;
+                    return _error;
+                }
+            }
+
+            if (!retry || _attempts >= _max_attempts) {
+                return _error;
+            }
+
+            wait_ms(_retry_delay_ms);
+        }
+    }
+
+    /**
+     * The result of the last run().
+     */
+    nsapi_error_t get_error() {
+        return _error;
+    }
+
+    /**
+     * Status code of the last response, 0 if none was received.
+     */
+    int get_status_code() {
+        return _status_code;
+    }
+
+    /**
+     * Number of requests the last run() took.
+     */
+    uint32_t get_attempts() {
+        return _attempts;
+    }
+
+    /**
+     * Number of times the download started over, because the server sent the complete resource instead of the rest.
+     */
+    uint32_t get_restarts() {
+        return _restarts;
+    }
+
+private:
+    void init() {
+        memset(&_state, 0, sizeof(_state));
+        _max_attempts = HTTP_DOWNLOAD_MAX_ATTEMPTS;
+        _retry_delay_ms = HTTP_DOWNLOAD_RETRY_DELAY;
+        _attempts = 0;
+        _restarts = 0;
+        _status_code = 0;
+        _error = NSAPI_ERROR_OK;
+        _accepting = false;
+        _complete = false;
+        _checkpoint_offset = 0;
+        _attempt_error = NSAPI_ERROR_OK;
+        _attempt_retry = false;
+    }
+
+    nsapi_error_t attempt(bool* retry) {
+        HttpRequestBase* req = create_request(callback(this, &ResumableDownload::on_body));
+
+        if (_state.offset > 0) {
+            char range[24];
+            snprintf(range, sizeof(range), "bytes=%lu-", (unsigned long)_state.offset);
+            req->set_header("Range", range);
+
+            if (_state.validator[0] != '\0') {
+                req->set_header("If-Range", _state.validator);
+            }
+        }
+
+        req->set_headers_callback(callback(this, &ResumableDownload::on_headers));
+        if (_request_cb) {
+            _request_cb(req);
+        }
+
+        _accepting = false;
+        _complete = false;
+        _checkpoint_offset = _state.offset;
+        _attempt_error = NSAPI_ERROR_OK;
+        _attempt_retry = false;
+
+        HttpResponse* res = req->send();
+        _status_code = res ? res->get_status_code() : 0;
+
+        nsapi_error_t ret = NSAPI_ERROR_OK;
+        *retry = false;
+
+        if (_attempt_error != NSAPI_ERROR_OK) {
+            // decided when the headers came in
+            ret = _attempt_error;
+            *retry = _attempt_retry;
+        }
+        else if (_sink->get_error() != NSAPI_ERROR_OK) {
+            ret = _sink->get_error();
+        }
+        else if (!res) {
+            ret = req->get_error();
+            *retry = true;
+        }
+        else if (!res->is_message_complete()) {
+            // connection dropped in the middle of the body
+            ret = NSAPI_ERROR_CONNECTION_LOST;
+            *retry = true;
+        }
+        else if (!_complete && !_accepting) {
+            ret = -2103;
+        }
+
+        delete req;
+        return ret;
+    }
+
+    void on_headers(HttpResponse* res) {
+        int status = res->get_status_code();
+        uint32_t start = 0, total = 0;
+
+        if (status == 206) {
+            if (!parse_content_range(res->get_header(HTTP_HEADER_CONTENT_RANGE), &start, &total) || start != _state.offset) {
+                _attempt_error = -2103;
+                return;
+            }
+            if (total != 0) {
+                _state.total = total;
+            }
+            store_validator(res);
+            _accepting = true;
+        }
+        else if (status == 200) {
+            if (_state.offset > 0) {
+                // the resource changed (If-Range did not match), or the server ignores ranges
+                nsapi_error_t ret = _sink->restart();
+                if (ret != NSAPI_ERROR_OK) {
+                    _attempt_error = ret;
+                    return;
+                }
+                _state.offset = 0;
+                _checkpoint_offset = 0;
+                _restarts++;
+            }
+            HttpStringView length = res->get_header(HTTP_HEADER_CONTENT_LENGTH);
+            _state.total = length.data ? parse_number(length.data, length.length, NULL) : 0;
+            store_validator(res);
+            _accepting = true;
+        }
+        else if (status == 416 && _state.offset > 0) {
+            // nothing left to send, or the resource got smaller: then start over
+            parse_content_range(res->get_header(HTTP_HEADER_CONTENT_RANGE), &start, &total);
+            if (total == _state.offset) {
+                _state.total = total;
+                _complete = true;
+                return;
+            }
+
+            nsapi_error_t ret = _sink->restart();
+            _attempt_error = ret != NSAPI_ERROR_OK ? ret : -2103;
+            _attempt_retry = ret == NSAPI_ERROR_OK;
+            memset(&_state, 0, sizeof(_state));
+            _restarts++;
+        }
+        else {
+            // server errors can be temporary
+            _attempt_error = -2103;
+            _attempt_retry = status >= 500;
+        }
+    }
+
+    void on_body(const char* at, uint32_t length) {
+        if (!_accepting) {
+            return;
+        }
+
+        _sink->on_body(at, length);
+        if (_sink->get_error() != NSAPI_ERROR_OK) {
+            _accepting = false;
+            return;
+        }
+
+        _state.offset += length;
+
+        if (_state.offset - _checkpoint_offset >= HTTP_DOWNLOAD_CHECKPOINT_SIZE) {
+            nsapi_error_t ret = checkpoint();
+            if (ret != NSAPI_ERROR_OK) {
+                _attempt_error = ret;
+                _accepting = false;
+            }
+        }
+    }
+
+    nsapi_error_t checkpoint() {
+        _checkpoint_offset = _state.offset;
+
+        nsapi_error_t ret = _sink->flush();
+        if (ret == NSAPI_ERROR_UNSUPPORTED) {
+            // the sink cannot store partial data, progress only lives as long as the sink
+            return NSAPI_ERROR_OK;
+        }
+        if (ret != NSAPI_ERROR_OK) {
+            return ret;
+        }
+
+        if (_state_cb) {
+            _state_cb(&_state);
+        }
+        return NSAPI_ERROR_OK;
+    }
+
+    void store_validator(HttpResponse* res) {
+        HttpStringView value = get_validator(res);
+
+        _state.validator[0] = '\0';
+        if (value.data && value.length < HTTP_DOWNLOAD_VALIDATOR_SIZE) {
+            memcpy(_state.validator, value.data, value.length);
+            _state.validator[value.length] = '\0';
+        }
+    }
+
+    BodySink* _sink;
+
+    DownloadState _state;
+    Callback<void(const DownloadState*)> _state_cb;
+    Callback<void(HttpRequestBase*)> _request_cb;
+
+    uint32_t _max_attempts;
+    uint32_t _retry_delay_ms;
+    uint32_t _attempts;
+    uint32_t _restarts;
+    int _status_code;
+    nsapi_error_t _error;
+
+    // state of the current attempt
+    bool _accepting;
+    bool _complete;
+    uint32_t _checkpoint_offset;
+    nsapi_error_t _attempt_error;
+    bool _attempt_retry;
+};
+
+#endif // _MBED_HTTP_RESUMABLE_DOWNLOAD_H_
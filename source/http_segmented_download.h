@@ -0,0 +1,678 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MBED_HTTP_SEGMENTED_DOWNLOAD_H_
+#define _MBED_HTTP_SEGMENTED_DOWNLOAD_H_
+
+#include <string>
+#include <vector>
+#include "mbed.h"
+#include "http_body_sink.h"
+#include "http_download_base.h"
+
+#ifndef HTTP_SEGMENTED_CONNECTIONS
+#define HTTP_SEGMENTED_CONNECTIONS 4
+#endif
+
+#ifndef HTTP_SEGMENTED_MIN_SEGMENT_SIZE
+#define HTTP_SEGMENTED_MIN_SEGMENT_SIZE 16 * 1024
+#endif
+
+using namespace std;
+
+/**
+ * Progress of one segment of a SegmentedDownload.
+ */
+struct DownloadSegment {
+    uint32_t start;         // offset of the first byte of the segment
+    uint32_t end;           // offset after the last byte of the segment, 0 while the size of the resource is unknown
+    uint32_t received;      // number of bytes stored in the sink
+    uint32_t requests;      // number of requests the segment took
+    uint32_t elapsed_ms;    // time since the first request of the segment was sent, until it completed
+    uint32_t throughput;    // received bytes per second
+};
+
+/**
+ * \brief SegmentedDownload fetches a resource over several connections at once, each requesting a byte range.
+ *
+ * The first request asks for 'Range: bytes=0-'. If the server answers with 206 Partial Content, the size of the
+ * resource is known and it is split in up to max_connections segments; the first request keeps the first segment,
+ * and a request per other segment is started. Every segment is written at its own offset in a RandomAccessSink.
+ * If the server answers with 200 OK, the resource is downloaded over the first connection only, and a failed
+ * request starts over from the first byte.
+ *
+ * When a connection finishes its segment while others are still busy, the segment that is expected to take the
+ * longest (by its throughput so far) is split in two, and the connection continues with the second half. The
+ * original request is cancelled once it reaches the new end of its segment.
+ *
+ * Failed segments are requested again from where they stopped, up to HTTP_DOWNLOAD_MAX_ATTEMPTS requests per
+ * segment. All requests run on one event queue (see HttpRequestBase::send_async()), on the thread that calls run().
+ */
+class SegmentedDownload : public HttpDownloadBase {
+public:
+    /**
+     * SegmentedDownload Constructor, for http:// URLs
+     *
+     * @param[in] queue Event queue on which all requests are processed
+     * @param[in] network The network interface
+     * @param[in] url URL to the resource
+     * @param[in] sink Where the resource is stored, needs to outlive the download
+     * @param[in] max_connections Maximum number of requests in flight at the same time
+     */
+    SegmentedDownload(EventQueue* queue, NetworkInterface* network, const char* url, RandomAccessSink* sink,
+                      uint32_t max_connections = HTTP_SEGMENTED_CONNECTIONS)
+        : HttpDownloadBase(network, url, NULL, NULL), _queue(queue), _sink(sink)
+    {
+        init(max_connections);
+    }
+
+    /**
+     * SegmentedDownload Constructor, for https:// URLs
+     *
+     * @param[in] queue Event queue on which all requests are processed
+     * @param[in] network The network interface
+     * @param[in] ssl_ca_pem String containing the trusted CAs
+     * @param[in] url URL to the resource
+     * @param[in] sink Where the resource is stored, needs to outlive the download
+     * @param[in] max_connections Maximum number of requests in flight at the same time
+     */
+    SegmentedDownload(EventQueue* queue, NetworkInterface* network, const char* ssl_ca_pem, const char* url,
+                      RandomAccessSink* sink, uint32_t max_connections = HTTP_SEGMENTED_CONNECTIONS)
+        : HttpDownloadBase(network, url, ssl_ca_pem, NULL), _queue(queue), _sink(sink)
+    {
+        init(max_connections);
+    }
+
+    /**
+     * SegmentedDownload Constructor, for https:// URLs
+     *
+     * @param[in] queue Event queue on which all requests are processed
+     * @param[in] network The network interface
+     * @param[in] ca_store Store containing the trusted CAs, needs to outlive the download
+     * @param[in] url URL to the resource
+     * @param[in] sink Where the resource is stored, needs to outlive the download
+     * @param[in] max_connections Maximum number of requests in flight at the same time
+     */
+    SegmentedDownload(EventQueue* queue, NetworkInterface* network, CertificateStore* ca_store, const char* url,
+                      RandomAccessSink* sink, uint32_t max_connections = HTTP_SEGMENTED_CONNECTIONS)
+        : HttpDownloadBase(network, url, NULL, ca_store), _queue(queue), _sink(sink)
+    {
+        init(max_connections);
+    }
+
+    ~SegmentedDownload() {
+        clear();
+    }
+
+    /**
+     * Set a callback that is called with every request before it is sent, e.g. to add headers,
+     * or to set a DNS cache.
+     */
+    void set_request_callback(Callback<void(HttpRequestBase*)> request_cb) {
+        _request_cb = request_cb;
+    }
+
+    /**
+     * Set how often a segment is requested before the download fails, and how long to wait before a retry.
+     */
+    void set_retry(uint32_t max_attempts, uint32_t retry_delay_ms) {
+        _max_attempts = max_attempts < 1 ? 1 : max_attempts;
+        _retry_delay_ms = retry_delay_ms;
+    }
+
+    /**
+     * Set the smallest segment. Segments are not split if both halves would be smaller than this.
+     */
+    void set_min_segment_size(uint32_t min_segment_size) {
+        _min_segment_size = min_segment_size < 1 ? 1 : min_segment_size;
+    }
+
+    /**
+     * Download the resource, and dispatch the queue until it is complete or failed.
+     * Blocks the calling thread, which becomes the thread that drives all requests.
+     *
+     * @return NSAPI_ERROR_OK when the complete resource is in the sink (and the sink was finished),
+     *         -2103 if the server replied with an unexpected status (see get_status_code()) or Content-Range,
+     *         the error of the sink, or the error of the last request of the segment that failed.
+     */
+    nsapi_error_t run() {
+        clear();
+
+        _error = NSAPI_ERROR_OK;
+        _status_code = 0;
+        _total = 0;
+        _ranges = false;
+        _validator.clear();
+        _active = 0;
+        _rebalances = 0;
+        _retry_scheduled = false;
+        _start_scheduled = false;
+
+        // the first segment doubles as the probe for the size of the resource
+        add_segment(0, 0);
+
+        if (_queue->call(this, &SegmentedDownload::start_pending) == 0) {
+            _error = NSAPI_ERROR_NO_MEMORY;
+            return _error;
+        }
+        _start_scheduled = true;
+        _queue->dispatch_forever();
+
+        return _error;
+    }
+
+    /**
+     * The result of the last run().
+     */
+    nsapi_error_t get_error() {
+        return _error;
+    }
+
+    /**
+     * Status code of the last response, 0 if none was received.
+     */
+    int get_status_code() {
+        return _status_code;
+    }
+
+    /**
+     * Size of the resource, 0 if it is not known.
+     */
+    uint32_t get_total_size() {
+        return _total;
+    }
+
+    /**
+     * Number of segments of the last run(), in the order they were created (not by offset).
+     */
+    uint32_t get_segment_count() {
+        return _segments.size();
+    }
+
+    /**
+     * Progress and throughput of a segment.
+     */
+    DownloadSegment get_segment(uint32_t ix) {
+        return _segments[ix]->stats;
+    }
+
+    /**
+     * Number of times a slow segment was split to keep all connections busy.
+     */
+    uint32_t get_rebalances() {
+        return _rebalances;
+    }
+
+private:
+    struct Segment {
+        SegmentedDownload* download;
+        DownloadSegment stats;
+        HttpRequestBase* request;
+        uint32_t request_end;       // end of the range that was requested, 0 if open ended
+        uint64_t started_ms;
+        uint64_t retry_at_ms;
+        bool accepting;
+        bool complete;
+        nsapi_error_t error;        // decided when the headers came in
+        bool retry;
+
+        uint32_t remaining() {
+            return stats.end - stats.start - stats.received;
+        }
+
+        void on_headers(HttpResponse* response) {
+            download->on_segment_headers(this, response);
+        }
+
+        void on_body(const char* at, uint32_t length) {
+            download->on_segment_body(this, at, length);
+        }
+
+        void on_done(HttpResponse* response) {
+            download->on_segment_done(this, response);
+        }
+    };
+
+    void init(uint32_t max_connections) {
+        _max_connections = max_connections < 1 ? 1 : max_connections;
+        _max_attempts = HTTP_DOWNLOAD_MAX_ATTEMPTS;
+        _retry_delay_ms = HTTP_DOWNLOAD_RETRY_DELAY;
+        _min_segment_size = HTTP_SEGMENTED_MIN_SEGMENT_SIZE;
+        _error = NSAPI_ERROR_OK;
+        _status_code = 0;
+        _total = 0;
+        _ranges = false;
+        _active = 0;
+        _deleting = 0;
+        _rebalances = 0;
+        _retry_scheduled = false;
+        _start_scheduled = false;
+    }
+
+    void clear() {
+        for (size_t ix = 0; ix < _segments.size(); ix++) {
+            delete _segments[ix]->request;
+            delete _segments[ix];
+        }
+        _segments.clear();
+    }
+
+    Segment* add_segment(uint32_t start, uint32_t end) {
+        Segment* seg = new Segment();
+        memset(&seg->stats, 0, sizeof(seg->stats));
+        seg->download = this;
+        seg->stats.start = start;
+        seg->stats.end = end;
+        seg->request = NULL;
+        seg->request_end = 0;
+        seg->started_ms = 0;
+        seg->retry_at_ms = 0;
+        seg->accepting = false;
+        seg->complete = false;
+        seg->error = NSAPI_ERROR_OK;
+        seg->retry = false;
+        _segments.push_back(seg);
+        return seg;
+    }
+
+    void start_segment(Segment* seg) {
+        HttpRequestBase* req = create_request(callback(seg, &Segment::on_body));
+
+        uint32_t offset = seg->stats.start + seg->stats.received;
+        char range[24];
+        if (seg->stats.end == 0) {
+            snprintf(range, sizeof(range), "bytes=%lu-", (unsigned long)offset);
+        }
+        else {
+            snprintf(range, sizeof(range), "bytes=%lu-%lu", (unsigned long)offset, (unsigned long)seg->stats.end - 1);
+        }
+        req->set_header("Range", range);
+        if (!_validator.empty()) {
+            req->set_header("If-Range", _validator);
+        }
+
+        req->set_headers_callback(callback(seg, &Segment::on_headers));
+        if (_request_cb) {
+            _request_cb(req);
+        }
+
+        if (seg->stats.requests == 0) {
+            seg->started_ms = Kernel::get_ms_count();
+        }
+        seg->stats.requests++;
+        seg->request_end = seg->stats.end;
+        seg->accepting = false;
+        seg->error = NSAPI_ERROR_OK;
+        seg->retry = false;
+
+        nsapi_error_t ret = req->send_async(_queue, callback(seg, &Segment::on_done));
+        if (ret != NSAPI_ERROR_OK) {
+            // failed before anything was scheduled
+            delete req;
+            segment_failed(seg, ret, true);
+            return;
+        }
+
+        seg->request = req;
+        _active++;
+    }
+
+    // One pending call is enough, it starts everything that can be started
+    void schedule_start_pending() {
+        if (_start_scheduled) {
+            return;
+        }
+
+        _start_scheduled = _queue->call(this, &SegmentedDownload::start_pending) != 0;
+        if (!_start_scheduled && _active == 0 && !_retry_scheduled && _deleting == 0) {
+            // the queue is full, and nothing that is still in flight would schedule it again
+            if (_error == NSAPI_ERROR_OK) {
+                _error = NSAPI_ERROR_NO_MEMORY;
+            }
+            _queue->break_dispatch();
+        }
+    }
+
+    // Runs from the queue, never from within a request's callbacks
+    void start_pending() {
+        _start_scheduled = false;
+
+        if (_error == NSAPI_ERROR_OK) {
+            uint64_t now = Kernel::get_ms_count();
+            bool waiting = false;
+
+            for (size_t ix = 0; ix < _segments.size() && _active < _max_connections && _error == NSAPI_ERROR_OK; ix++) {
+                Segment* seg = _segments[ix];
+                if (seg->complete || seg->request) {
+                    continue;
+                }
+                if (seg->retry_at_ms > now) {
+                    waiting = true;
+                    continue;
+                }
+                start_segment(seg);
+            }
+
+            while (_ranges && !waiting && _active < _max_connections && _error == NSAPI_ERROR_OK) {
+                if (!split_slowest_segment()) {
+                    break;
+                }
+            }
+
+            if (waiting) {
+                schedule_retry_pending();
+            }
+        }
+
+        // run() returns once nothing of the download is left on the queue
+        if (_active > 0 || _retry_scheduled || _deleting > 0) {
+            return;
+        }
+
+        if (_error == NSAPI_ERROR_OK) {
+            _error = check_complete();
+        }
+        if (_error == NSAPI_ERROR_OK) {
+            _error = _sink->finish();
+        }
+        _queue->break_dispatch();
+    }
+
+    // Nothing is in flight anymore, but that does not mean every byte arrived
+    nsapi_error_t check_complete() {
+        uint32_t received = 0;
+        for (size_t ix = 0; ix < _segments.size(); ix++) {
+            Segment* seg = _segments[ix];
+            if (!seg->complete) {
+                return seg->error != NSAPI_ERROR_OK ? seg->error : NSAPI_ERROR_CONNECTION_LOST;
+            }
+            received += seg->stats.received;
+        }
+
+        return received == _total ? NSAPI_ERROR_OK : NSAPI_ERROR_CONNECTION_LOST;
+    }
+
+    void schedule_retry_pending() {
+        if (!_retry_scheduled) {
+            // if the queue is full, the download ends when nothing else is in flight (see check_complete())
+            _retry_scheduled = _queue->call_in(_retry_delay_ms, this, &SegmentedDownload::retry_pending) != 0;
+        }
+    }
+
+    void retry_pending() {
+        _retry_scheduled = false;
+        schedule_start_pending();
+    }
+
+    // Hands the second half of the segment that will take the longest to a new connection
+    bool split_slowest_segment() {
+        uint32_t average = average_throughput();
+        Segment* slowest = NULL;
+        uint64_t slowest_eta = 0;
+
+        for (size_t ix = 0; ix < _segments.size(); ix++) {
+            Segment* seg = _segments[ix];
+            if (!seg->request || seg->complete || seg->stats.end == 0 || seg->remaining() < 2 * _min_segment_size) {
+                continue;
+            }
+
+            // segments that did not receive anything yet are assumed to be as fast as the others
+            uint32_t throughput = seg->stats.received > 0 ? seg->stats.throughput : average;
+            uint64_t eta = (uint64_t)seg->remaining() * 1000 / (throughput > 0 ? throughput : 1);
+            if (!slowest || eta > slowest_eta) {
+                slowest = seg;
+                slowest_eta = eta;
+            }
+        }
+
+        if (!slowest) {
+            return false;
+        }
+
+        uint32_t end = slowest->stats.end;
+        uint32_t middle = end - slowest->remaining() / 2;
+        slowest->stats.end = middle;
+        _rebalances++;
+
+        start_segment(add_segment(middle, end));
+        return true;
+    }
+
+    uint32_t average_throughput() {
+        uint64_t sum = 0;
+        uint32_t count = 0;
+        for (size_t ix = 0; ix < _segments.size(); ix++) {
+            if (_segments[ix]->stats.received > 0) {
+                sum += _segments[ix]->stats.throughput;
+                count++;
+            }
+        }
+        return count > 0 ? sum / count : 0;
+    }
+
+    // Called once the first request learned the size of the resource
+    void plan_segments(Segment* first) {
+        uint32_t count = _total / _min_segment_size;
+        if (count > _max_connections) {
+            count = _max_connections;
+        }
+        if (count < 1) {
+            count = 1;
+        }
+
+        uint32_t size = _total / count;
+        first->stats.end = size;
+        for (uint32_t ix = 1; ix < count; ix++) {
+            add_segment(ix * size, ix == count - 1 ? _total : (ix + 1) * size);
+        }
+
+        schedule_start_pending();
+    }
+
+    void on_segment_headers(Segment* seg, HttpResponse* res) {
+        int status = res->get_status_code();
+        _status_code = status;
+
+        // until the server did a range request, there is only the first segment
+        bool probe = !_ranges;
+        uint32_t start = 0, total = 0;
+
+        if (status == 206) {
+            if (!parse_content_range(res->get_header(HTTP_HEADER_CONTENT_RANGE), &start, &total)
+                || start != seg->stats.start + seg->stats.received || (probe && total == 0)) {
+                reject_segment(seg, -2103, false);
+                return;
+            }
+
+            if (probe) {
+                nsapi_error_t ret = _sink->set_size(total);
+                if (ret != NSAPI_ERROR_OK) {
+                    reject_segment(seg, ret, false);
+                    return;
+                }
+                _total = total;
+                _ranges = true;
+                store_validator(res);
+                plan_segments(seg);
+            }
+            seg->accepting = true;
+        }
+        else if (status == 200 && probe && seg->stats.received == 0) {
+            // no ranges, everything comes over this connection
+            HttpStringView length = res->get_header(HTTP_HEADER_CONTENT_LENGTH);
+            _total = length.data ? parse_number(length.data, length.length, NULL) : 0;
+
+            nsapi_error_t ret = _sink->set_size(_total);
+            if (ret != NSAPI_ERROR_OK) {
+                reject_segment(seg, ret, false);
+                return;
+            }
+            seg->stats.end = _total;
+            seg->request_end = _total;
+            seg->accepting = true;
+        }
+        else {
+            // 200 for a segment means the resource changed (If-Range did not match); server errors can be temporary
+            reject_segment(seg, -2103, status >= 500);
+        }
+    }
+
+    void on_segment_body(Segment* seg, const char* at, uint32_t length) {
+        if (!seg->accepting) {
+            return;
+        }
+
+        if (seg->stats.end != 0 && length > seg->remaining()) {
+            // the segment was split, the rest belongs to another connection
+            length = seg->remaining();
+        }
+        if (length == 0) {
+            return;
+        }
+
+        nsapi_error_t ret = _sink->write_at(seg->stats.start + seg->stats.received, at, length);
+        if (ret != NSAPI_ERROR_OK) {
+            reject_segment(seg, ret, false);
+            return;
+        }
+
+        seg->stats.received += length;
+        update_throughput(seg);
+
+        if (seg->stats.end != 0 && seg->remaining() == 0 && seg->request_end != seg->stats.end) {
+            // requested more than the segment holds now
+            seg->accepting = false;
+            seg->request->cancel_async();
+        }
+    }
+
+    void on_segment_done(Segment* seg, HttpResponse* res) {
+        HttpRequestBase* req = seg->request;
+        seg->request = NULL;
+        _active--;
+
+        // still on the request's call stack, delete it from the queue (after steps it already scheduled)
+        bool delete_now = _queue->call(this, &SegmentedDownload::delete_request, req) == 0;
+        if (!delete_now) {
+            _deleting++;
+        }
+
+        if (seg->error != NSAPI_ERROR_OK) {
+            segment_failed(seg, seg->error, seg->retry);
+        }
+        else if (seg->stats.end != 0 ? seg->remaining() == 0 : (res && res->is_message_complete())) {
+            seg->complete = true;
+            update_throughput(seg);
+            if (seg->stats.end == 0) {
+                _total = seg->stats.received;
+                seg->stats.end = _total;
+            }
+        }
+        else {
+            if (!_ranges) {
+                // cannot continue where it stopped, start over (the sink is overwritten from the start)
+                seg->stats.received = 0;
+            }
+            segment_failed(seg, res ? NSAPI_ERROR_CONNECTION_LOST : req->get_error(), true);
+        }
+
+        schedule_start_pending();
+
+        if (delete_now) {
+            // queue is full: the request does not touch itself after its done callback returns
+            delete req;
+        }
+    }
+
+    // Stops the segment's request from one of its callbacks
+    void reject_segment(Segment* seg, nsapi_error_t error, bool retry) {
+        seg->accepting = false;
+        seg->error = error;
+        seg->retry = retry;
+        seg->request->cancel_async();
+    }
+
+    void segment_failed(Segment* seg, nsapi_error_t error, bool retry) {
+        // reported if the segment is never completed
+        seg->error = error;
+
+        if (retry && seg->stats.requests < _max_attempts) {
+            // also when the request failed before it was sent: then nothing else would wake up the download
+            seg->retry_at_ms = Kernel::get_ms_count() + _retry_delay_ms;
+            schedule_retry_pending();
+            return;
+        }
+
+        if (_error != NSAPI_ERROR_OK) {
+            return;
+        }
+
+        // stop the others, run() returns once all of them are done
+        _error = error;
+        for (size_t ix = 0; ix < _segments.size(); ix++) {
+            if (_segments[ix]->request) {
+                _segments[ix]->accepting = false;
+                _segments[ix]->request->cancel_async();
+            }
+        }
+    }
+
+    void update_throughput(Segment* seg) {
+        seg->stats.elapsed_ms = Kernel::get_ms_count() - seg->started_ms;
+        if (seg->stats.elapsed_ms > 0) {
+            seg->stats.throughput = (uint64_t)seg->stats.received * 1000 / seg->stats.elapsed_ms;
+        }
+    }
+
+    void store_validator(HttpResponse* res) {
+        HttpStringView value = get_validator(res);
+
+        _validator.clear();
+        if (value.data) {
+            _validator.assign(value.data, value.length);
+        }
+    }
+
+    void delete_request(HttpRequestBase* req) {
+        delete req;
+        _deleting--;
+        schedule_start_pending();
+    }
+
+    EventQueue* _queue;
+    RandomAccessSink* _sink;
+
+    Callback<void(HttpRequestBase*)> _request_cb;
+    uint32_t _max_connections;
+    uint32_t _max_attempts;
+    uint32_t _retry_delay_ms;
+    uint32_t _min_segment_size;
+
+    vector<Segment*> _segments;
+    uint32_t _active;
+    uint32_t _deleting;
+    uint32_t _total;
+    bool _ranges;
+    string _validator;
+    uint32_t _rebalances;
+    bool _retry_scheduled;
+    bool _start_scheduled;
+    int _status_code;
+    nsapi_error_t _error;
+};
+
+#endif // _MBED_HTTP_SEGMENTED_DOWNLOAD_H_
@@ -22,6 +22,9 @@
 #include <vector>
 #include <map>
 #include "http_request_base.h"
+#include "certificate_store.h"
+#include "tls_session_cache.h"
+#include "tls_session_socket.h"
 #include "TLSSocket.h"
 
 #ifndef HTTP_RECEIVE_BUFFER_SIZE
@@ -56,10 +59,43 @@ public:
     _request_builder = new HttpRequestBuilder(method, _parsed_url);
     _response = NULL;
 
-    _socket = new TLSSocket();
-    ((TLSSocket*)_socket)->open(network);
-    ((TLSSocket*)_socket)->set_root_ca_cert(ssl_ca_pem);
+    // socket is opened (or taken from the connection pool) when the request is sent
+    _ssl_ca_pem = ssl_ca_pem;
+    _ca_store = NULL;
     _network = network;
+    _session_cache = NULL;
+
+    _we_created_socket = true;
+  }
+
+  /**
+   * HttpsRequest Constructor
+   * Same as above, but uses a pre-parsed set of trusted CAs, so the PEM bundle is not parsed again for every request.
+   *
+   * @param[in] network The network interface
+   * @param[in] ca_store Store containing the trusted CAs, needs to outlive the request
+   * @param[in] method HTTP method to use
+   * @param[in] url URL to the resource
+   * @param[in] body_callback Callback on which to retrieve chunks of the response body.
+                              If not set, the complete body will be allocated on the HttpResponse object,
+                              which might use lots of memory.
+   */
+  HttpsRequest(NetworkInterface* network,
+               CertificateStore* ca_store,
+               http_method method,
+               const char* url,
+               Callback<void(const char *at, uint32_t length)> body_callback = 0)
+      : HttpRequestBase(NULL, body_callback)
+  {
+    _parsed_url = new ParsedUrl(url);
+    _request_builder = new HttpRequestBuilder(method, _parsed_url);
+    _response = NULL;
+
+    // socket is opened (or taken from the connection pool) when the request is sent
+    _ssl_ca_pem = NULL;
+    _ca_store = ca_store;
+    _network = network;
+    _session_cache = NULL;
 
     _we_created_socket = true;
   }
@@ -85,26 +121,67 @@ public:
     _body_callback = body_callback;
     _request_builder = new HttpRequestBuilder(method, _parsed_url);
     _response = NULL;
-    _network = nullptr;
+    _ssl_ca_pem = NULL;
+    _ca_store = NULL;
+    _session_cache = NULL;
 
     _we_created_socket = false;
   }
 
    virtual ~HttpsRequest() {}
 
+  /**
+   * Use a TLS session cache for this request.
+   * New connections are made with a TLSSessionSocket: when the host is in the cache, the stored
+   * session is offered to the server so it can do an abbreviated handshake. After the handshake
+   * the negotiated session is stored in the cache.
+   *
+   * @param cache The cache to use, needs to outlive the request
+   */
+  void set_session_cache(TLSSessionCache* cache) {
+    _session_cache = cache;
+  }
+
 private:
-  NetworkInterface* _network;
+  const char* _ssl_ca_pem;
+  CertificateStore* _ca_store;
+  TLSSessionCache* _session_cache;
 
 protected:
-  virtual nsapi_error_t connect_socket(char *host, uint16_t port) {
-    if(!_we_created_socket)
-      return NSAPI_ERROR_PARAMETER;
-    SocketAddress adr;
-    NetworkInterface *net = NetworkInterface::get_default_instance();
-    net->gethostbyname(host, &adr);
-    adr.set_port(port);
-    ((TLSSocket*)_socket)->set_hostname(host);
-    return ((TLSSocket*)_socket)->connect(adr);
+  virtual nsapi_error_t open_socket() {
+    TLSSocketWrapper* socket;
+    nsapi_error_t ret;
+
+    if (_session_cache) {
+      TLSSessionSocket* session_socket = new TLSSessionSocket(_session_cache, _parsed_url->host());
+      ret = session_socket->open(_network);
+      socket = session_socket;
+    }
+    else {
+      TLSSocket* tls_socket = new TLSSocket();
+      ret = tls_socket->open(_network);
+      socket = tls_socket;
+    }
+
+    _socket = socket;
+    if (ret != NSAPI_ERROR_OK) {
+      return ret;
+    }
+
+    if (_ca_store) {
+      _ca_store->attach(socket);
+      return NSAPI_ERROR_OK;
+    }
+
+    return socket->set_root_ca_cert(_ssl_ca_pem);
+  }
+
+  virtual nsapi_error_t connect_socket(SocketAddress addr) {
+    // TLSSessionSocket restores and stores the session itself
+    TLSSocketWrapper* socket = (TLSSocketWrapper*)_socket;
+    socket->set_hostname(_parsed_url->host());
+
+    return socket->connect(addr);
   }
 };
 
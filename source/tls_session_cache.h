@@ -0,0 +1,203 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MBED_HTTP_TLS_SESSION_CACHE_H_
+#define _MBED_HTTP_TLS_SESSION_CACHE_H_
+
+#include <string>
+#include <vector>
+#include "mbed.h"
+#include "mbedtls/ssl.h"
+
+#ifndef HTTP_TLS_SESSION_CACHE_SIZE
+#define HTTP_TLS_SESSION_CACHE_SIZE 4
+#endif
+
+using namespace std;
+
+/**
+ * \brief TLSSessionCache stores negotiated TLS sessions (session ID or ticket) per host,
+ * so later connections to the same host can do an abbreviated handshake.
+ *
+ * A cache can be shared between HttpsRequest objects and between threads.
+ */
+class TLSSessionCache {
+public:
+    /**
+     * TLSSessionCache Constructor
+     *
+     * @param[in] max_entries Maximum number of hosts to keep a session for
+     */
+    TLSSessionCache(uint32_t max_entries = HTTP_TLS_SESSION_CACHE_SIZE)
+        : _max_entries(max_entries), _hits(0), _misses(0)
+    {}
+
+    ~TLSSessionCache() {
+        clear();
+    }
+
+    /**
+     * Offer the cached session for this host to a TLS context. The context needs to be set up
+     * (mbedtls_ssl_setup) and the handshake not started yet, TLSSessionSocket takes care of this.
+     *
+     * @return true if a session was found and accepted by the TLS context
+     */
+    bool restore(const char* host, mbedtls_ssl_context* ssl) {
+        bool restored = false;
+
+        _mutex.lock();
+        int ix = find(host);
+        if (ix >= 0) {
+            restored = mbedtls_ssl_set_session(ssl, _entries[ix].session) == 0;
+        }
+        _mutex.unlock();
+
+        return restored;
+    }
+
+    /**
+     * Whether a session is cached for this host.
+     */
+    bool contains(const char* host) {
+        _mutex.lock();
+        bool found = find(host) >= 0;
+        _mutex.unlock();
+        return found;
+    }
+
+    /**
+     * Store the session of a TLS context that just finished its handshake.
+     * An existing session for this host is replaced.
+     *
+     * If the handshake re-used the stored session (same master secret) it's counted as a hit,
+     * otherwise as a miss.
+     */
+    void save(const char* host, mbedtls_ssl_context* ssl) {
+        mbedtls_ssl_session* session = (mbedtls_ssl_session*)calloc(1, sizeof(mbedtls_ssl_session));
+        if (!session) {
+            return;
+        }
+        mbedtls_ssl_session_init(session);
+
+        if (mbedtls_ssl_get_session(ssl, session) != 0) {
+            mbedtls_ssl_session_free(session);
+            free(session);
+            return;
+        }
+
+        _mutex.lock();
+        int ix = find(host);
+        if (ix >= 0 && memcmp(_entries[ix].session->master, session->master, sizeof(session->master)) == 0) {
+            _hits++;
+        }
+        else {
+            _misses++;
+        }
+
+        if (ix >= 0) {
+            remove(ix);
+        }
+
+        // entries are in insertion order, drop the oldest one when full
+        while (_entries.size() >= _max_entries && _entries.size() > 0) {
+            remove(0);
+        }
+
+        Entry entry;
+        entry.host = host;
+        entry.session = session;
+        _entries.push_back(entry);
+        _mutex.unlock();
+    }
+
+    /**
+     * Forget the session for a host, e.g. after a failed handshake.
+     */
+    void invalidate(const char* host) {
+        _mutex.lock();
+        int ix = find(host);
+        if (ix >= 0) {
+            remove(ix);
+        }
+        _mutex.unlock();
+    }
+
+    /**
+     * Forget all sessions.
+     */
+    void clear() {
+        _mutex.lock();
+        while (_entries.size() > 0) {
+            remove(0);
+        }
+        _mutex.unlock();
+    }
+
+    /**
+     * Number of handshakes that resumed a cached session (abbreviated handshake).
+     */
+    uint32_t get_hits() {
+        return _hits;
+    }
+
+    /**
+     * Number of handshakes that needed a full handshake, because no session was cached or the server declined it.
+     */
+    uint32_t get_misses() {
+        return _misses;
+    }
+
+    /**
+     * Number of hosts that currently have a cached session.
+     */
+    uint32_t get_size() {
+        _mutex.lock();
+        uint32_t size = _entries.size();
+        _mutex.unlock();
+        return size;
+    }
+
+private:
+    struct Entry {
+        string host;
+        mbedtls_ssl_session* session;
+    };
+
+    int find(const char* host) {
+        for (size_t ix = 0; ix < _entries.size(); ix++) {
+            if (_entries[ix].host == host) {
+                return ix;
+            }
+        }
+        return -1;
+    }
+
+    void remove(size_t ix) {
+        mbedtls_ssl_session_free(_entries[ix].session);
+        free(_entries[ix].session);
+        _entries.erase(_entries.begin() + ix);
+    }
+
+    uint32_t _max_entries;
+    uint32_t _hits;
+    uint32_t _misses;
+
+    vector<Entry> _entries;
+    PlatformMutex _mutex;
+};
+
+#endif // _MBED_HTTP_TLS_SESSION_CACHE_H_
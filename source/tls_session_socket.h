@@ -0,0 +1,170 @@
+/*
+ * PackageLicenseDeclared: Apache-2.0
+ * Copyright (c) 2018 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MBED_HTTP_TLS_SESSION_SOCKET_H_
+#define _MBED_HTTP_TLS_SESSION_SOCKET_H_
+
+#include <string>
+#include "mbed.h"
+#include "TCPSocket.h"
+#include "TLSSocketWrapper.h"
+#include "mbedtls/ssl.h"
+#include "tls_session_cache.h"
+
+using namespace std;
+
+/**
+ * \brief TLSSessionSocket is a TLS socket over TCP (like TLSSocket) that resumes sessions from a TLSSessionCache.
+ *
+ * TLSSocketWrapper only sets up its TLS context when the handshake starts, and writes the ClientHello
+ * in the same call, so there is no point where a session can be offered from the outside. This socket
+ * starts the handshake while holding back everything written to the TCP socket, resets the TLS context,
+ * offers the cached session, and then lets the handshake run. Nothing is sent before the session is offered.
+ * After a successful handshake the session is stored in the cache again.
+ */
+class TLSSessionSocket : public TLSSocketWrapper {
+public:
+    /**
+     * TLSSessionSocket Constructor
+     *
+     * @param[in] cache Cache to take the session from and store it in, needs to outlive the socket
+     * @param[in] hostname Host name of the server, used for SNI, certificate verification and as cache key
+     */
+    TLSSessionSocket(TLSSessionCache* cache, const char* hostname)
+        : TLSSocketWrapper(&_transport, hostname, TRANSPORT_CLOSE), _cache(cache), _host(hostname),
+          _state(STATE_CONNECTING), _timeout(-1)
+    {}
+
+    virtual ~TLSSessionSocket() {
+        // _transport is destroyed before TLSSocketWrapper, which would still use it when closing
+        close();
+    }
+
+    /**
+     * Open the underlying TCP socket.
+     */
+    nsapi_error_t open(NetworkInterface* network) {
+        return _transport.open(network);
+    }
+
+    virtual nsapi_error_t connect(const SocketAddress& address) {
+        nsapi_error_t ret;
+
+        if (_state == STATE_CONNECTING) {
+            ret = _transport.connect(address);
+            if (ret != NSAPI_ERROR_OK && ret != NSAPI_ERROR_IS_CONNECTED) {
+                return ret;
+            }
+
+            _state = STATE_HANDSHAKING;
+
+            if (_cache->contains(_host.c_str())) {
+                ret = offer_session(address);
+                if (ret != NSAPI_ERROR_OK) {
+                    _state = STATE_DONE;
+                    return ret;
+                }
+            }
+        }
+
+        ret = TLSSocketWrapper::connect(address);
+
+        if (_state == STATE_HANDSHAKING) {
+            if (ret == NSAPI_ERROR_OK || ret == NSAPI_ERROR_IS_CONNECTED) {
+                _cache->save(_host.c_str(), get_ssl_context());
+                _state = STATE_DONE;
+            }
+            else if (ret != NSAPI_ERROR_WOULD_BLOCK && ret != NSAPI_ERROR_IN_PROGRESS && ret != NSAPI_ERROR_ALREADY) {
+                // don't offer a session that the server might have choked on again
+                _cache->invalidate(_host.c_str());
+                _state = STATE_DONE;
+            }
+        }
+
+        return ret;
+    }
+
+    virtual void set_blocking(bool blocking) {
+        set_timeout(blocking ? -1 : 0);
+    }
+
+    virtual void set_timeout(int timeout) {
+        _timeout = timeout;
+
+        // TLSSocketWrapper does not connect the TCP socket for us, so it doesn't pass the timeout on either
+        if (_state == STATE_CONNECTING) {
+            _transport.set_timeout(timeout);
+        }
+        TLSSocketWrapper::set_timeout(timeout);
+    }
+
+private:
+    // TCP socket that can hold back everything written to it
+    class HeldTCPSocket : public TCPSocket {
+    public:
+        HeldTCPSocket() : _held(false) {}
+
+        void hold(bool held) {
+            _held = held;
+        }
+
+        virtual nsapi_size_or_error_t send(const void* data, nsapi_size_t size) {
+            if (_held) {
+                return NSAPI_ERROR_WOULD_BLOCK;
+            }
+            return TCPSocket::send(data, size);
+        }
+
+    private:
+        bool _held;
+    };
+
+    enum state {
+        STATE_CONNECTING,
+        STATE_HANDSHAKING,
+        STATE_DONE
+    };
+
+    nsapi_error_t offer_session(const SocketAddress& address) {
+        // sets up the TLS context, the ClientHello stays in its output buffer
+        TLSSocketWrapper::set_timeout(0);
+        _transport.hold(true);
+        nsapi_error_t ret = TLSSocketWrapper::connect(address);
+        _transport.hold(false);
+        TLSSocketWrapper::set_timeout(_timeout);
+
+        if (ret != NSAPI_ERROR_WOULD_BLOCK && ret != NSAPI_ERROR_IN_PROGRESS && ret != NSAPI_ERROR_ALREADY) {
+            return ret;
+        }
+
+        // drops the unsent ClientHello, the next connect() writes a new one with the session in it
+        if (mbedtls_ssl_session_reset(get_ssl_context()) != 0) {
+            return NSAPI_ERROR_NO_MEMORY;
+        }
+
+        _cache->restore(_host.c_str(), get_ssl_context());
+        return NSAPI_ERROR_OK;
+    }
+
+    HeldTCPSocket _transport;
+    TLSSessionCache* _cache;
+    string _host;
+    state _state;
+    int _timeout;
+};
+
+#endif // _MBED_HTTP_TLS_SESSION_SOCKET_H_